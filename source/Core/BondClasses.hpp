@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "Core/Bonds.hpp"
+#include "Core/Stresses.hpp"
+#include "Misc/Tags/TagMap.hpp"
+#include "Misc/Tags/TagStorage.hpp"
+
+namespace networkV4
+{
+
+static_assert(NUM_TAGS <= 8, "tag classes are stored in a byte");
+
+// Bonds grouped by tag class, the exact set of tag bits a bond has, so class
+// c holds the bonds whose tags are c. Each bond's class is kept in a byte
+// array for the force loop, and each class has a sorted list of its bonds.
+// A tag's bonds are the union of the classes with that bit. Breaking a bond
+// moves it to the class with the broken bit set in O(1): it is appended to
+// the new list and left in the old one, and compact drops the stale entries
+// and restores the order once per scan rather than once per break.
+class bondClasses
+{
+public:
+  static constexpr size_t NUM_CLASSES = std::tuple_size_v<classStresses>;
+
+public:
+  bondClasses() = default;
+
+public:
+  void rebuild(const bonded::bonds& _bonds)
+  {
+    const auto& tags = _bonds.getTags();
+    m_class.resize(tags.size());
+    for (auto& members : m_members) {
+      members.clear();
+    }
+    m_counts.fill(0);
+    m_stale.fill(false);
+    for (size_t i = 0; i < tags.size(); i++) {
+      m_class[i] = static_cast<std::uint8_t>(tags[i].to_ulong());
+      m_members[m_class[i]].push_back(i);
+      m_counts[m_class[i]]++;
+    }
+  }
+
+  // Drops the entries left behind by breaks and sorts the lists they were
+  // appended to, O(B) at most
+  void compact()
+  {
+    for (size_t c = 0; c < NUM_CLASSES; c++) {
+      if (!m_stale[c]) {
+        continue;
+      }
+      auto& members = m_members[c];
+      members.erase(std::remove_if(members.begin(),
+                                   members.end(),
+                                   [&](size_t _index)
+                                   { return m_class[_index] != c; }),
+                    members.end());
+      std::sort(members.begin(), members.end());
+      m_stale[c] = false;
+    }
+  }
+
+  // Moves bond _index, which had _tags, to its broken class
+  void recordBreak(size_t _index, const Utils::Tags::tagFlags& _tags)
+  {
+    if (_index >= m_class.size() || _tags.test(BROKEN_TAG_INDEX)) {
+      return;
+    }
+    auto newTags = _tags;
+    newTags.set(BROKEN_TAG_INDEX);
+    move(_index, static_cast<std::uint8_t>(newTags.to_ulong()));
+  }
+
+  // Number of bonds classified at the last rebuild
+  auto size() const -> size_t { return m_class.size(); }
+
+  auto classOf(size_t _index) const -> std::uint8_t { return m_class[_index]; }
+  auto classIds() const -> const std::vector<std::uint8_t>& { return m_class; }
+
+  // Sorted bonds of _class, once compacted after the last break
+  auto members(size_t _class) const -> const std::vector<size_t>&
+  {
+    return m_members[_class];
+  }
+
+  static auto tags(size_t _class) -> Utils::Tags::tagFlags
+  {
+    return Utils::Tags::tagFlags(_class);
+  }
+
+  // Classes with any of the tags in _filter, all classes if it is empty
+  static auto matching(const Utils::Tags::tagFlags& _filter)
+      -> std::vector<size_t>
+  {
+    std::vector<size_t> classes;
+    for (size_t c = 0; c < NUM_CLASSES; c++) {
+      if (_filter.none() || Utils::Tags::hasTagAny(tags(c), _filter)) {
+        classes.push_back(c);
+      }
+    }
+    return classes;
+  }
+
+  // Number of bonds with any of the tags in _filter
+  auto count(const Utils::Tags::tagFlags& _filter) const -> size_t
+  {
+    size_t total = 0;
+    for (const auto c : matching(_filter)) {
+      total += m_counts[c];
+    }
+    return total;
+  }
+
+private:
+  void move(size_t _index, std::uint8_t _to)
+  {
+    const std::uint8_t from = m_class[_index];
+    m_counts[from]--;
+    m_counts[_to]++;
+    m_stale[from] = true;
+    m_stale[_to] = true;
+    m_members[_to].push_back(_index);
+    m_class[_index] = _to;
+  }
+
+private:
+  std::vector<std::uint8_t> m_class;
+  std::array<std::vector<size_t>, NUM_CLASSES> m_members;
+  std::array<size_t, NUM_CLASSES> m_counts {};  // live entries of m_members
+  std::array<bool, NUM_CLASSES> m_stale {};  // needs compact
+};
+
+}  // namespace networkV4
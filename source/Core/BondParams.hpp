@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Core/Bonds.hpp"
+#include "Misc/Config.hpp"
+#include "Misc/Math/Vector.hpp"
+
+namespace networkV4
+{
+
+// Bond parameters deduplicated into a shared table. Each bond keeps a small
+// id into the table and its own rest length, so the force loop streams 10
+// bytes per bond rather than both variants. The variants in bonded::bonds stay
+// the authoritative storage, so the table adds to the bond memory rather than
+// replacing it. It is built from them, follows breaks, and is rebuilt when
+// bonds::structure changes. Forces, energies and breaks match the variants
+// bit for bit.
+class bondParams
+{
+  static_assert(std::variant_size_v<bonded::bondTypes> == 2
+                    && std::variant_size_v<bonded::breakTypes> == 2,
+                "bondParams only knows the harmonic and strain break types");
+
+public:
+  using paramId = std::uint16_t;
+
+  // Id 0, the parameters of a broken bond
+  static constexpr paramId VIRTUAL = 0;
+
+  struct entry
+  {
+    bool harmonic = false;
+    bool normalized = false;
+    bool strainBreak = false;
+    double k = 0.0;  // as given, see HarmonicBond::baseK
+    double lambda = 0.0;
+
+    auto key() const
+    {
+      return std::tie(harmonic, normalized, k, strainBreak, lambda);
+    }
+    auto operator<(const entry& _other) const -> bool
+    {
+      return key() < _other.key();
+    }
+  };
+
+public:
+  bondParams() = default;
+
+public:
+  // Builds the table from the bond variants. The table is unusable if a bond's
+  // break and spring rest lengths differ or there are too many combinations.
+  void rebuild(const bonded::bonds& _bonds)
+  {
+    const auto& types = _bonds.getTypes();
+    const auto& breaks = _bonds.getBreaks();
+    const size_t B = types.size();
+
+    m_table.assign(1, entry {});
+    m_ids.resize(B);
+    m_r0.resize(B);
+    m_usable = true;
+
+    std::map<entry, paramId> index {{entry {}, VIRTUAL}};
+    for (size_t i = 0; i < B; i++) {
+      entry params;
+      std::optional<double> r0;
+      if (const auto* bond = std::get_if<Forces::HarmonicBond>(&types[i])) {
+        params.harmonic = true;
+        params.normalized = bond->normalized();
+        params.k = bond->baseK();
+        r0 = bond->r0();
+      }
+      if (const auto* brk = std::get_if<BreakTypes::StrainBreak>(&breaks[i])) {
+        if (r0 && r0.value() != brk->r0()) {
+          m_usable = false;
+        }
+        params.strainBreak = true;
+        params.lambda = brk->lambda();
+        r0 = brk->r0();
+      }
+
+      auto [it, added] =
+          index.try_emplace(params, static_cast<paramId>(m_table.size()));
+      if (added) {
+        if (m_table.size() > std::numeric_limits<paramId>::max()) {
+          m_usable = false;
+        }
+        m_table.push_back(params);
+      }
+      m_ids[i] = it->second;
+      m_r0[i] = r0.value_or(0.0);
+    }
+  }
+
+  // Bond _index broke and is now virtual
+  void recordBreak(size_t _index)
+  {
+    if (_index < m_ids.size()) {
+      m_ids[_index] = VIRTUAL;
+    }
+  }
+
+  // Number of bonds in the table at the last rebuild
+  auto size() const -> size_t { return m_ids.size(); }
+  auto usable() const -> bool { return m_usable; }
+  auto entries() const -> const std::vector<entry>& { return m_table; }
+  auto params(size_t _index) const -> const entry&
+  {
+    return m_table[m_ids[_index]];
+  }
+  auto restLength(size_t _index) const -> double { return m_r0[_index]; }
+
+  // Force and energy of bond _index, as HarmonicBond::force and energy
+  auto evaluate(size_t _index, const Utils::Math::vec2d& _dist) const
+      -> std::pair<std::optional<Utils::Math::vec2d>, std::optional<double>>
+  {
+    const auto& params = m_table[m_ids[_index]];
+    if (!params.harmonic) {
+      return {std::nullopt, std::nullopt};
+    }
+    const double r0 = m_r0[_index];
+    const double k = params.normalized ? params.k / r0 : params.k;
+    const auto r = _dist.norm();
+    const auto dr = r - r0;
+    auto fac = -k * dr;
+    if (r > ROUND_ERROR_PRECISION) {
+      fac /= r;
+    } else {
+      throw("HarmonicBond::force: r is too small");
+    }
+    return {_dist * fac, 0.5 * k * dr * dr};
+  }
+
+  // As StrainBreak::checkBreak
+  auto breaks(size_t _index, const Utils::Math::vec2d& _dist) const -> bool
+  {
+    const auto& params = m_table[m_ids[_index]];
+    if (!params.strainBreak) {
+      return false;
+    }
+    return (_dist.norm() * (1.0 / m_r0[_index])) - 1.0 > params.lambda;
+  }
+
+private:
+  std::vector<entry> m_table;
+  std::vector<paramId> m_ids;
+  std::vector<double> m_r0;
+  bool m_usable = false;
+};
+
+}  // namespace networkV4
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Core/Network.hpp"
+#include "Misc/Tags/TagStorage.hpp"
+#include "Misc/TournamentTree.hpp"
+
+namespace networkV4
+{
+
+enum class priorityKey : std::uint8_t
+{
+  threshold,  // visitThreshold, > 0 once the bond breaks
+  data,  // visitData, e.g. the bond strain
+};
+
+// Bonds ordered by how close they are to failure. The keys are read from the
+// network's break keys, recorded by its force passes, and each key and tag
+// filter has a tournament tree, built the first time it is queried. A refresh
+// after a pass only updates the bonds the pass listed as changed, in place
+// unless most bonds changed. Bonds without break data (broken or unbreakable)
+// never appear. An empty filter matches all bonds, otherwise a bond matches if
+// it has any of the filter tags.
+class bondPriority
+{
+public:
+  bondPriority() = default;
+
+public:
+  // Brings the keys up to date with _network. Only the changed bonds are
+  // taken if the keys were last read at the base of the network's recording,
+  // otherwise all keys are copied. Keys that are not current, after a pass
+  // without breaks or stresses, are recomputed from the positions.
+  void refresh(const network& _network)
+  {
+    const auto& bonds = _network.getBonds();
+    if (!_network.breakKeysCurrent()) {
+      m_threshold.resize(bonds.size());
+      m_data.resize(bonds.size());
+      m_tags = bonds.getTags();
+      computeKeys(_network);
+      rebuildTrees();
+      m_keysId = 0;
+      return;
+    }
+
+    const auto& keys = _network.getBreakKeys();
+    if (keys.id() == m_keysId && bonds.structure() == m_structure) {
+      return;
+    }
+
+    const auto& changed = keys.changed();
+    if (m_keysId == 0 || keys.base() != m_keysId
+        || bonds.structure() != m_structure || m_tags.size() != keys.size())
+    {
+      m_threshold = keys.threshold();
+      m_data = keys.data();
+      m_tags = bonds.getTags();
+      rebuildTrees();
+    } else if (changed.size() * REBUILD_FRACTION > m_tags.size()) {
+      copyChanged(_network);
+      rebuildTrees();
+    } else {
+      copyChanged(_network);
+      for (const auto i : changed) {
+        for (auto& entry : m_trees) {
+          entry.tree.update(i, keyOf(entry.key, entry.filter, i));
+        }
+      }
+    }
+    m_keysId = keys.id();
+    m_structure = bonds.structure();
+  }
+
+  // Bond with the largest key and its value
+  auto top(priorityKey _key, const Utils::Tags::tagFlags& _filter = {})
+      -> std::optional<std::pair<size_t, double>>
+  {
+    const auto& tree = getTree(_key, _filter);
+    const size_t index = tree.top();
+    if (index == tree.size()) {
+      return std::nullopt;
+    }
+    return std::make_pair(index, tree.value(index));
+  }
+
+  // Up to _k bonds with keys above _above, largest first
+  auto topK(priorityKey _key,
+            size_t _k,
+            double _above = LOWEST,
+            const Utils::Tags::tagFlags& _filter = {})
+      -> std::vector<std::pair<size_t, double>>
+  {
+    const auto& tree = getTree(_key, _filter);
+    std::vector<std::pair<size_t, double>> result;
+    for (const auto index : tree.topK(_k, _above)) {
+      result.emplace_back(index, tree.value(index));
+    }
+    return result;
+  }
+
+  // Number of bonds with keys above _above, O(count log B)
+  auto countAbove(priorityKey _key,
+                  double _above,
+                  const Utils::Tags::tagFlags& _filter = {}) -> size_t
+  {
+    return getTree(_key, _filter).topK(m_tags.size(), _above).size();
+  }
+
+private:
+  static constexpr double LOWEST = Utils::tournamentTree::LOWEST;
+
+  // Trees are rebuilt rather than updated once more than 1 / REBUILD_FRACTION
+  // of the bonds changed
+  static constexpr size_t REBUILD_FRACTION = 8;
+
+  struct treeEntry
+  {
+    priorityKey key;
+    Utils::Tags::tagFlags filter;
+    Utils::tournamentTree tree;
+  };
+
+  void rebuildTrees()
+  {
+    for (auto& entry : m_trees) {
+      entry.tree.build(filtered(entry.key, entry.filter));
+    }
+  }
+
+  // Keys and tags of the bonds the network's last recording changed
+  void copyChanged(const network& _network)
+  {
+    const auto& keys = _network.getBreakKeys();
+    const auto& tags = _network.getBonds().getTags();
+    for (const auto i : keys.changed()) {
+      m_threshold[i] = keys.threshold()[i];
+      m_data[i] = keys.data()[i];
+      m_tags[i] = tags[i];
+    }
+  }
+
+  // Every key from the current positions
+  void computeKeys(const network& _network)
+  {
+    const auto& positions = _network.getNodes().positions();
+    const auto& bonds = _network.getBonds();
+    const auto& box = _network.getBox();
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < m_tags.size(); i++) {
+      const auto& bond = bonds.getBonds()[i];
+      const auto dist =
+          box.minDist(positions[bond.src], positions[bond.dst]);
+      const auto& brk = bonds.getBreaks()[i];
+      m_threshold[i] = bonded::visitThreshold(brk, dist).value_or(LOWEST);
+      m_data[i] = bonded::visitData(brk, dist).value_or(LOWEST);
+    }
+  }
+
+  auto keyOf(priorityKey _key,
+             const Utils::Tags::tagFlags& _filter,
+             size_t _index) const -> double
+  {
+    if (_filter.any() && !Utils::Tags::hasTagAny(m_tags[_index], _filter)) {
+      return LOWEST;
+    }
+    return _key == priorityKey::threshold ? m_threshold[_index]
+                                          : m_data[_index];
+  }
+
+  auto filtered(priorityKey _key, const Utils::Tags::tagFlags& _filter) const
+      -> std::vector<double>
+  {
+    std::vector<double> values(m_tags.size());
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < values.size(); i++) {
+      values[i] = keyOf(_key, _filter, i);
+    }
+    return values;
+  }
+
+  auto getTree(priorityKey _key, const Utils::Tags::tagFlags& _filter)
+      -> const Utils::tournamentTree&
+  {
+    for (const auto& entry : m_trees) {
+      if (entry.key == _key && entry.filter == _filter) {
+        return entry.tree;
+      }
+    }
+    m_trees.push_back(
+        {_key, _filter, Utils::tournamentTree(filtered(_key, _filter))});
+    return m_trees.back().tree;
+  }
+
+private:
+  std::vector<double> m_threshold;
+  std::vector<double> m_data;
+  std::vector<Utils::Tags::tagFlags> m_tags;
+  std::vector<treeEntry> m_trees;
+
+  // Recording the keys were last read at, 0 if they were computed here
+  std::uint64_t m_keysId = 0;
+  std::uint64_t m_structure = 0;
+};
+
+}  // namespace networkV4
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
+
+#include "Core/BondClasses.hpp"
+#include "Core/Network.hpp"
+#include "Misc/Math/Vector.hpp"
+#include "Misc/Tags/TagStorage.hpp"
+
+#if defined(_OPENMP)
+#  include "Core/OMP/OMP.hpp"
+#endif
+
+namespace networkV4
+{
+namespace query
+{
+
+// Parallel scans over the bonds. A key maps (bond index, bond vector) to an
+// optional value, bonds without a value are skipped, and the values are fed
+// to a reduction. Each reduction has add(index, value) and merge(other);
+// threads reduce their own ranges and the results are merged in range order,
+// so the result does not depend on scheduling.
+
+// Largest value and its bond, index is npos if there were no values
+struct maxArg
+{
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  double value = std::numeric_limits<double>::lowest();
+  size_t index = npos;
+
+  void add(size_t _index, double _value)
+  {
+    if (index == npos || _value > value) {
+      value = _value;
+      index = _index;
+    }
+  }
+  void merge(const maxArg& _other)
+  {
+    if (_other.index != npos) {
+      add(_other.index, _other.value);
+    }
+  }
+  auto found() const -> bool { return index != npos; }
+};
+
+// Number of values above _above
+struct count
+{
+  double above = std::numeric_limits<double>::lowest();
+  size_t value = 0;
+
+  void add(size_t, double _value) { value += _value > above; }
+  void merge(const count& _other) { value += _other.value; }
+};
+
+struct sum
+{
+  double value = 0.0;
+
+  void add(size_t, double _value) { value += _value; }
+  void merge(const sum& _other) { value += _other.value; }
+};
+
+// Equal width bins over [lo, hi), values outside are counted separately
+struct histogram
+{
+  histogram(double _lo, double _hi, size_t _bins)
+      : lo(_lo)
+      , hi(_hi)
+      , bins(_bins, 0)
+  {
+  }
+
+  double lo;
+  double hi;
+  std::vector<size_t> bins;
+  size_t below = 0;
+  size_t above = 0;
+
+  void add(size_t, double _value)
+  {
+    if (_value < lo) {
+      below++;
+    } else if (_value >= hi) {
+      above++;
+    } else {
+      const auto bin = static_cast<size_t>((_value - lo) / (hi - lo)
+                                           * static_cast<double>(bins.size()));
+      bins[std::min(bin, bins.size() - 1)]++;
+    }
+  }
+  void merge(const histogram& _other)
+  {
+    for (size_t i = 0; i < bins.size(); i++) {
+      bins[i] += _other.bins[i];
+    }
+    below += _other.below;
+    above += _other.above;
+  }
+};
+
+// Bonds with values above _above, in scan order
+struct collect
+{
+  double above = std::numeric_limits<double>::lowest();
+  std::vector<size_t> indices;
+
+  void add(size_t _index, double _value)
+  {
+    if (_value > above) {
+      indices.push_back(_index);
+    }
+  }
+  void merge(const collect& _other)
+  {
+    indices.insert(
+        indices.end(), _other.indices.begin(), _other.indices.end());
+  }
+};
+
+// Several reductions of the same values in one pass
+template<typename... Reductions>
+struct combine
+{
+  combine(Reductions... _reductions)
+      : parts(std::move(_reductions)...)
+  {
+  }
+
+  std::tuple<Reductions...> parts;
+
+  void add(size_t _index, double _value)
+  {
+    std::apply([&](auto&... _r) { (_r.add(_index, _value), ...); }, parts);
+  }
+  void merge(const combine& _other)
+  {
+    mergeParts(_other, std::index_sequence_for<Reductions...> {});
+  }
+
+private:
+  template<size_t... I>
+  void mergeParts(const combine& _other, std::index_sequence<I...>)
+  {
+    (std::get<I>(parts).merge(std::get<I>(_other.parts)), ...);
+  }
+};
+
+// Contiguous bond ranges to scan, the OMP partitions when they cover the
+// bonds, otherwise an even split over the network's team
+inline auto bondRanges(const network& _network)
+    -> std::vector<std::pair<size_t, size_t>>
+{
+  const size_t B = _network.getBonds().size();
+  std::vector<std::pair<size_t, size_t>> parts;
+
+#if defined(_OPENMP)
+  size_t covered = 0;
+  for (const auto& part : _network.getContext().partitions()) {
+    if (part.bondStart() < part.bondEnd()) {
+      parts.emplace_back(part.bondStart(), part.bondEnd());
+      covered += part.bondCount();
+    }
+  }
+  std::sort(parts.begin(), parts.end());
+  if (covered == B) {
+    return parts;
+  }
+  parts.clear();
+#endif
+  const size_t chunks = _network.getContext().teamSize(B);
+
+  for (size_t c = 0; c < chunks; c++) {
+    parts.emplace_back(B * c / chunks, B * (c + 1) / chunks);
+  }
+  return parts;
+}
+
+// Slices of the tag class lists matching _filter, each class split evenly
+// over the network's team
+inline auto classRanges(const network& _network,
+                        const Utils::Tags::tagFlags& _filter)
+    -> std::vector<std::pair<const size_t*, const size_t*>>
+{
+  const size_t chunks =
+      _network.getContext().teamSize(_network.getBonds().size());
+  const auto& classes = _network.getClasses();
+  std::vector<std::pair<const size_t*, const size_t*>> parts;
+  for (const auto c : bondClasses::matching(_filter)) {
+    const auto& members = classes.members(c);
+    const size_t M = members.size();
+    for (size_t k = 0; k < chunks && M > 0; k++) {
+      parts.emplace_back(members.data() + M * k / chunks,
+                         members.data() + M * (k + 1) / chunks);
+    }
+  }
+  return parts;
+}
+
+// Feeds _key(index, dist) of every bond matching _filter to _reduction, which
+// should be empty apart from its parameters. An empty filter matches all
+// bonds in index order, otherwise the bonds with any of the tags are taken
+// from the tag class lists, class by class.
+template<typename Reduction, typename Key>
+auto scan(const network& _network,
+          const Utils::Tags::tagFlags& _filter,
+          Key&& _key,
+          Reduction _reduction) -> Reduction
+{
+  const auto& positions = _network.getNodes().positions();
+  const auto& bonds = _network.getBonds().getBonds();
+  const auto& box = _network.getBox();
+
+  auto visit = [&](Reduction& _local, size_t _index)
+  {
+    const auto& bond = bonds[_index];
+    const auto dist = box.minDist(positions[bond.src], positions[bond.dst]);
+    const std::optional<double> value = _key(_index, dist);
+    if (value) {
+      _local.add(_index, value.value());
+    }
+  };
+
+  std::vector<Reduction> partial;
+  if (_filter.none()) {
+    const auto parts = bondRanges(_network);
+    partial.assign(parts.size(), _reduction);
+#pragma omp parallel for schedule(dynamic, 1) \
+    num_threads(_network.getContext().teamSize(parts.size()))
+    for (size_t r = 0; r < parts.size(); r++) {
+      for (size_t i = parts[r].first; i < parts[r].second; i++) {
+        visit(partial[r], i);
+      }
+    }
+  } else {
+    const auto parts = classRanges(_network, _filter);
+    partial.assign(parts.size(), _reduction);
+#pragma omp parallel for schedule(dynamic, 1) \
+    num_threads(_network.getContext().teamSize(parts.size()))
+    for (size_t r = 0; r < parts.size(); r++) {
+      for (const size_t* it = parts[r].first; it != parts[r].second; ++it) {
+        visit(partial[r], *it);
+      }
+    }
+  }
+
+  if (partial.empty()) {
+    return _reduction;
+  }
+  for (size_t r = 1; r < partial.size(); r++) {
+    partial[0].merge(partial[r]);
+  }
+  return partial[0];
+}
+
+}  // namespace query
+}  // namespace networkV4
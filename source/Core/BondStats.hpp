@@ -0,0 +1,104 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <variant>
+
+#include "Core/Bonds.hpp"
+#include "Misc/Tags/TagMap.hpp"
+#include "Misc/Tags/TagStorage.hpp"
+
+namespace networkV4
+{
+
+// Bond counts kept up to date as bonds break, so they are O(1) to read. A
+// bond is live unless it is a VirtualBond. Counts per tag are kept for each
+// tag bit, so a query tag should be a single tag as returned by tagMap::get.
+class bondStats
+{
+public:
+  bondStats() = default;
+
+public:
+  // Counts every bond from scratch
+  void rebuild(const bonded::bonds& _bonds)
+  {
+    m_size = _bonds.size();
+    m_live = 0;
+    m_tagged.fill(0);
+    m_liveTagged.fill(0);
+
+    const auto& types = _bonds.getTypes();
+    const auto& tags = _bonds.getTags();
+    for (size_t i = 0; i < m_size; i++) {
+      const bool live = isLive(types[i]);
+      m_live += live;
+      for (size_t bit = 0; bit < NUM_TAGS; bit++) {
+        if (tags[i].test(bit)) {
+          m_tagged[bit]++;
+          m_liveTagged[bit] += live;
+        }
+      }
+    }
+  }
+
+  // Updates the counts for a bond that broke with _tags, _live if it was not
+  // a virtual bond
+  void recordBreak(bool _live, const Utils::Tags::tagFlags& _tags)
+  {
+    if (_live) {
+      m_live--;
+      for (size_t bit = 0; bit < NUM_TAGS; bit++) {
+        if (_tags.test(bit)) {
+          m_liveTagged[bit]--;
+        }
+      }
+    }
+    if (!_tags.test(BROKEN_TAG_INDEX)) {
+      m_tagged[BROKEN_TAG_INDEX]++;
+    }
+  }
+
+  // Number of bonds counted at the last rebuild
+  auto size() const -> size_t { return m_size; }
+
+  auto live() const -> size_t { return m_live; }
+  auto broken() const -> size_t { return m_tagged[BROKEN_TAG_INDEX]; }
+
+  // Bonds with _tag, broken or not
+  auto tagged(const Utils::Tags::tagFlags& _tag) const -> size_t
+  {
+    return m_tagged[bitOf(_tag)];
+  }
+
+  // Live bonds with _tag
+  auto live(const Utils::Tags::tagFlags& _tag) const -> size_t
+  {
+    return m_liveTagged[bitOf(_tag)];
+  }
+
+private:
+  static auto isLive(const bonded::bondTypes& _type) -> bool
+  {
+    return !std::holds_alternative<Forces::VirtualBond>(_type);
+  }
+
+  static auto bitOf(const Utils::Tags::tagFlags& _tag) -> size_t
+  {
+    for (size_t bit = 0; bit < NUM_TAGS; bit++) {
+      if (_tag.test(bit)) {
+        return bit;
+      }
+    }
+    throw std::runtime_error("bondStats: empty tag");
+  }
+
+private:
+  size_t m_size = 0;
+  size_t m_live = 0;
+  std::array<size_t, NUM_TAGS> m_tagged {};
+  std::array<size_t, NUM_TAGS> m_liveTagged {};
+};
+
+}  // namespace networkV4
@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <limits>
 #include <memory>
 #include <vector>
 
@@ -18,7 +19,10 @@ networkV4::bonded::bonds::bonds(const size_t _size)
 
 void networkV4::bonded::bonds::clear()
 {
+  m_generation++;
+  m_structure++;
   m_bonds.clear();
+  m_ids.clear();
   m_types.clear();
   m_breakTypes.clear();
     m_tags.clear();
@@ -27,6 +31,7 @@ void networkV4::bonded::bonds::clear()
 void networkV4::bonded::bonds::reserve(std::size_t _size)
 {
   m_bonds.reserve(_size);
+  m_ids.reserve(_size);
   m_types.reserve(_size);
   m_breakTypes.reserve(_size);
     m_tags.reserve(_size);
@@ -34,7 +39,7 @@ void networkV4::bonded::bonds::reserve(std::size_t _size)
 
 auto networkV4::bonded::bonds::size() const -> std::size_t
 {
-  if (m_bonds.size() != m_types.size() || m_bonds.size() != m_breakTypes.size() || m_bonds.size() != m_tags.size())
+  if (m_bonds.size() != m_types.size() || m_bonds.size() != m_breakTypes.size() || m_bonds.size() != m_tags.size() || m_bonds.size() != m_ids.size())
   {
     throw("bonds::size: inconsistent sizes");
   }
@@ -50,9 +55,15 @@ auto networkV4::bonded::bonds::addBond(size_t _src,
   if (_src == _dst) {
     throw("bonds::addBond: src and dst are the same");
   }
+  if (std::max(_src, _dst) > std::numeric_limits<nodeIndex>::max()) {
+    throw("bonds::addBond: node index too large for the compact topology");
+  }
   const std::size_t index = m_bonds.size();
+  m_generation++;
+  m_structure++;
 
-  m_bonds.emplace_back(_src, _dst, index);
+  m_bonds.emplace_back(_src, _dst);
+  m_ids.push_back(index);
   m_types.emplace_back(_bond);
   m_breakTypes.emplace_back(_break);
   m_tags.emplace_back(_tags);
@@ -81,33 +92,59 @@ auto networkV4::bonded::bonds::getTags() const -> const Utils::Tags::tagStorage&
   return m_tags;
 }
 
+auto networkV4::bonded::bonds::getIds() const
+    -> const std::vector<std::size_t>&
+{
+  return m_ids;
+}
+
 auto networkV4::bonded::bonds::getBonds() -> std::vector<BondInfo>&
 {
+  m_generation++;
   return m_bonds;
 }
 
 auto networkV4::bonded::bonds::getTypes() -> std::vector<bondTypes>&
 {
+  m_generation++;
   return m_types;
 }
 
 auto networkV4::bonded::bonds::getBreaks() -> std::vector<breakTypes>&
 {
+  m_generation++;
   return m_breakTypes;
 }
 
 auto networkV4::bonded::bonds::getTags() -> Utils::Tags::tagStorage&
 {
+  m_generation++;
   return m_tags;
 }
 
+auto networkV4::bonded::bonds::generation() const -> std::uint64_t
+{
+  return m_generation;
+}
+
+auto networkV4::bonded::bonds::structure() const -> std::uint64_t
+{
+  return m_structure;
+}
+
+void networkV4::bonded::bonds::invalidate()
+{
+  m_generation++;
+  m_structure++;
+}
+
 auto networkV4::bonded::bonds::gatherBonds() const
     -> std::vector<BondInfo> const
 {
   std::vector<BondInfo> bonds;
-  bonds.resize(size(), BondInfo(0, 0, 0));
-  for (const auto& bond : m_bonds) {
-    bonds[bond.index] = bond;
+  bonds.resize(size(), BondInfo(0, 0));
+  for (const auto& [bond, id] : ranges::views::zip(m_bonds, m_ids)) {
+    bonds[id] = bond;
   }
   return bonds;
 }
@@ -117,8 +154,8 @@ auto networkV4::bonded::bonds::gatherTypes() const
 {
   std::vector<bondTypes> types;
   types.resize(size());
-  for (const auto& [type, bond] : ranges::views::zip(m_types, m_bonds)) {
-    types[bond.index] = type;
+  for (const auto& [type, id] : ranges::views::zip(m_types, m_ids)) {
+    types[id] = type;
   }
   return types;
 }
@@ -128,8 +165,8 @@ auto networkV4::bonded::bonds::gatherBreaks() const
 {
   std::vector<breakTypes> breaks;
   breaks.resize(size());
-  for (const auto& [brk, bond] : ranges::views::zip(m_breakTypes, m_bonds)) {
-    breaks[bond.index] = brk;
+  for (const auto& [brk, id] : ranges::views::zip(m_breakTypes, m_ids)) {
+    breaks[id] = brk;
   }
   return breaks;
 }
@@ -139,21 +176,26 @@ auto networkV4::bonded::bonds::gatherTags() const
 {
   Utils::Tags::tagStorage tags;
   tags.resize(size());
-  for (const auto& [tag, bond] : ranges::views::zip(m_tags, m_bonds)) {
-    tags[bond.index] = tag;
+  for (const auto& [tag, id] : ranges::views::zip(m_tags, m_ids)) {
+    tags[id] = tag;
   }
   return tags;
 }
 
 void networkV4::bonded::bonds::remap(const NodeMap& _nodeMap)
 {
+  m_generation++;
+  m_structure++;
   for (auto [i, bond] : ranges::views::enumerate(m_bonds)) {
-    m_bonds[i] = BondInfo(_nodeMap.at(bond.src), _nodeMap.at(bond.dst), i);
+    m_bonds[i] = BondInfo(_nodeMap.at(bond.src), _nodeMap.at(bond.dst));
+    m_ids[i] = i;
   }
 }
 
 void networkV4::bonded::bonds::flipSrcDst()
 {
+  m_generation++;
+  m_structure++;
   for (auto& bond : m_bonds) {
     if (bond.src > bond.dst) {
       std::swap(bond.src, bond.dst);
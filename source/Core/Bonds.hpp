@@ -8,6 +8,7 @@
 #include "Core/BreakTypes/BondedBreak.hpp"
 #include "Core/Forces/BondedForces.hpp"
 #include "Core/Nodes.hpp"
+#include "Misc/Config.hpp"
 #include "Misc/Tags/TagStorage.hpp"
 
 namespace networkV4
@@ -15,20 +16,24 @@ namespace networkV4
 namespace bonded
 {
 
+#if COMPACT_TOPOLOGY
+using nodeIndex = std::uint32_t;
+#else
+using nodeIndex = std::size_t;
+#endif
+
+// The nodes a bond joins. Its id is kept apart in bonds::getIds, as only the
+// output needs it, so the force loop streams the endpoints alone.
 struct BondInfo
 {
   BondInfo() = delete;
-  BondInfo(const std::size_t _src,
-           const std::size_t _dst,
-           const std::size_t _index)
-      : src {_src}
-      , dst {_dst}
-      , index {_index}
+  BondInfo(const std::size_t _src, const std::size_t _dst)
+      : src {static_cast<nodeIndex>(_src)}
+      , dst {static_cast<nodeIndex>(_dst)}
   {
   }
-  std::size_t src;
-  std::size_t dst;
-  std::size_t index;
+  nodeIndex src;
+  nodeIndex dst;
 };
 
 class bonds
@@ -54,11 +59,26 @@ public:
   auto getBreaks() const -> const std::vector<breakTypes>&;
   auto getTags() const -> const Utils::Tags::tagStorage&;
 
+  // Id of each bond, its index when added or at the last remap
+  auto getIds() const -> const std::vector<std::size_t>&;
+
   auto getBonds() -> std::vector<BondInfo>&;
   auto getTypes() -> std::vector<bondTypes>&;
   auto getBreaks() -> std::vector<breakTypes>&;
   auto getTags() -> Utils::Tags::tagStorage&;
 
+  // Changes each time the bonds may have been written, including through the
+  // non-const accessors above
+  auto generation() const -> std::uint64_t;
+
+  // Changes when bonds are added, reordered or remapped, or on invalidate.
+  // Breaks leave it alone, the network's bond caches follow them one by one.
+  auto structure() const -> std::uint64_t;
+
+  // Call after editing types, breaks or tags in place other than by a break,
+  // so the network's bond caches are rebuilt
+  void invalidate();
+
 public:
   auto gatherBonds() const -> std::vector<BondInfo> const;
   auto gatherTypes() const -> std::vector<bondTypes> const;
@@ -78,8 +98,11 @@ public:
     if (_order.size() != size()) {
       throw("bonds::reorder: order size does not match bond size");
     }
+    m_generation++;
+    m_structure++;
 
-    ranges::sort(ranges::view::zip(_order, m_bonds, m_types, m_breakTypes, m_tags),
+    ranges::sort(ranges::view::zip(
+                     _order, m_bonds, m_ids, m_types, m_breakTypes, m_tags),
                  [fn](const auto& _a, const auto& _b)
                  { return fn(std::get<0>(_a), std::get<0>(_b)); });
   }
@@ -89,9 +112,13 @@ private:
 
 private:
   std::vector<BondInfo> m_bonds;
+  std::vector<std::size_t> m_ids;
   std::vector<bondTypes> m_types;
   std::vector<breakTypes> m_breakTypes;
   Utils::Tags::tagStorage m_tags;
+
+  std::uint64_t m_generation = 0;
+  std::uint64_t m_structure = 0;
 };
 
 }  // namespace bonded
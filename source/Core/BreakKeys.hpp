@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace networkV4
+{
+
+// Threshold and data keys of every bond (bonded::visitThreshold and
+// visitData), written by the force passes that evaluate breaks or stresses
+// from the distances they already compute. Bonds without break data have the
+// key LOWEST. Each recording gets an id unique across network copies and
+// lists the bonds whose keys changed since the recording base, so a reader
+// that last saw base catches up in O(changed).
+class breakKeys
+{
+public:
+  static constexpr double LOWEST = std::numeric_limits<double>::lowest();
+
+public:
+  breakKeys() = default;
+
+public:
+  // Starts a recording of _size bonds. A new size resets every key and the
+  // base, so readers start over.
+  void begin(size_t _size)
+  {
+    m_base = m_id;
+    m_id = nextId();
+    m_changed.clear();
+    if (m_threshold.size() != _size) {
+      m_threshold.assign(_size, LOWEST);
+      m_data.assign(_size, LOWEST);
+      m_base = 0;
+    }
+  }
+
+  // Sets the keys of bond _index, true if they changed. Safe to call for
+  // distinct bonds in parallel.
+  auto set(size_t _index, double _threshold, double _data) -> bool
+  {
+    if (m_threshold[_index] == _threshold && m_data[_index] == _data) {
+      return false;
+    }
+    m_threshold[_index] = _threshold;
+    m_data[_index] = _data;
+    return true;
+  }
+
+  // Lists bond _index as changed by the current recording
+  void changed(size_t _index) { m_changed.push_back(_index); }
+
+  // Clears the keys of bond _index after a break outside a pass. The base is
+  // kept, so readers at the base still only apply the changed bonds.
+  void recordBreak(size_t _index)
+  {
+    if (_index >= m_threshold.size()
+        || (m_threshold[_index] == LOWEST && m_data[_index] == LOWEST))
+    {
+      return;
+    }
+    m_threshold[_index] = LOWEST;
+    m_data[_index] = LOWEST;
+    m_changed.push_back(_index);
+    m_id = nextId();
+  }
+
+  auto size() const -> size_t { return m_threshold.size(); }
+  auto threshold() const -> const std::vector<double>& { return m_threshold; }
+  auto data() const -> const std::vector<double>& { return m_data; }
+
+  // Id of the recording, 0 before the first
+  auto id() const -> std::uint64_t { return m_id; }
+
+  // Id the changed bonds are relative to, 0 if unknown
+  auto base() const -> std::uint64_t { return m_base; }
+  auto changed() const -> const std::vector<size_t>& { return m_changed; }
+
+private:
+  static auto nextId() -> std::uint64_t
+  {
+    static std::atomic<std::uint64_t> next {1};
+    return next++;
+  }
+
+private:
+  std::vector<double> m_threshold;
+  std::vector<double> m_data;
+  std::vector<size_t> m_changed;
+  std::uint64_t m_id = 0;
+  std::uint64_t m_base = 0;
+};
+
+}  // namespace networkV4
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "Core/Bonds.hpp"
+#include "Misc/Tags/TagStorage.hpp"
+
+namespace networkV4
+{
+
+// A broken bond and the parameters it had before it broke, flat so events can
+// be copied and stored without touching the bond variants
+struct breakEvent
+{
+  size_t position;  // index in the bond arrays
+  size_t bond;  // id, see bonds::getIds
+  size_t src;
+  size_t dst;
+  Utils::Tags::tagFlags tags;
+
+  bool live;  // not a virtual bond
+  bool harmonic;
+  bool strainBreak;
+  double k;  // zero unless harmonic
+  double r0;
+  double lambda;  // zero unless strainBreak
+
+  // Network clock when the break was found
+  double strain;
+  double time;
+
+  static auto from(size_t _position,
+                   size_t _id,
+                   const bonded::BondInfo& _binfo,
+                   const bonded::bondTypes& _type,
+                   const bonded::breakTypes& _break,
+                   const Utils::Tags::tagFlags& _tags,
+                   double _strain,
+                   double _time) -> breakEvent
+  {
+    const auto* harmonic = std::get_if<Forces::HarmonicBond>(&_type);
+    const auto* strain = std::get_if<BreakTypes::StrainBreak>(&_break);
+    return {_position,
+            _id,
+            _binfo.src,
+            _binfo.dst,
+            _tags,
+            !std::holds_alternative<Forces::VirtualBond>(_type),
+            harmonic != nullptr,
+            strain != nullptr,
+            harmonic ? harmonic->k() : 0.0,
+            harmonic ? harmonic->r0() : 0.0,
+            strain ? strain->lambda() : 0.0,
+            _strain,
+            _time};
+  }
+};
+
+static_assert(std::is_trivially_copyable_v<breakEvent>);
+
+// FIFO ring buffer of break events. The storage doubles when full and is
+// never released, so once it has grown to the largest avalanche seen queueing
+// allocates nothing. drain hands the queue to a consumer as contiguous spans.
+class breakLog
+{
+public:
+  class const_iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = breakEvent;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const breakEvent*;
+    using reference = const breakEvent&;
+
+    const_iterator() = default;
+    const_iterator(const breakLog* _log, size_t _offset)
+        : m_log(_log)
+        , m_offset(_offset)
+    {
+    }
+
+    auto operator*() const -> reference { return (*m_log)[m_offset]; }
+    auto operator->() const -> pointer { return &(*m_log)[m_offset]; }
+    auto operator++() -> const_iterator&
+    {
+      m_offset++;
+      return *this;
+    }
+    auto operator++(int) -> const_iterator
+    {
+      auto copy = *this;
+      m_offset++;
+      return copy;
+    }
+    auto operator==(const const_iterator& _other) const -> bool
+    {
+      return m_offset == _other.m_offset;
+    }
+
+  private:
+    const breakLog* m_log = nullptr;
+    size_t m_offset = 0;
+  };
+
+public:
+  breakLog() = default;
+
+public:
+  void push_back(const breakEvent& _event)
+  {
+    if (m_size == m_buffer.size()) {
+      grow();
+    }
+    m_buffer[wrap(m_head + m_size)] = _event;
+    m_size++;
+  }
+
+  auto front() const -> const breakEvent&
+  {
+    if (m_size == 0) {
+      throw std::runtime_error("breakLog: front of empty log");
+    }
+    return m_buffer[m_head];
+  }
+
+  void pop_front()
+  {
+    if (m_size == 0) {
+      throw std::runtime_error("breakLog: pop of empty log");
+    }
+    m_head = wrap(m_head + 1);
+    m_size--;
+  }
+
+  // _offset events after the front
+  auto operator[](size_t _offset) const -> const breakEvent&
+  {
+    return m_buffer[wrap(m_head + _offset)];
+  }
+
+  auto size() const -> size_t { return m_size; }
+  auto empty() const -> bool { return m_size == 0; }
+  auto capacity() const -> size_t { return m_buffer.size(); }
+
+  void clear()
+  {
+    m_head = 0;
+    m_size = 0;
+  }
+
+  auto begin() const -> const_iterator { return {this, 0}; }
+  auto end() const -> const_iterator { return {this, m_size}; }
+
+  // Calls _consume with the queued events in order, as at most two spans,
+  // then empties the log. Returns the number of events.
+  template<typename Consume>
+  auto drain(Consume&& _consume) -> size_t
+  {
+    const size_t count = m_size;
+    const size_t first = std::min(m_size, m_buffer.size() - m_head);
+    if (first > 0) {
+      _consume(std::span<const breakEvent>(m_buffer.data() + m_head, first));
+    }
+    if (count > first) {
+      _consume(std::span<const breakEvent>(m_buffer.data(), count - first));
+    }
+    clear();
+    return count;
+  }
+
+private:
+  // Capacity is a power of two so wrapping is a mask
+  auto wrap(size_t _index) const -> size_t
+  {
+    return _index & (m_buffer.size() - 1);
+  }
+
+  void grow()
+  {
+    std::vector<breakEvent> buffer(std::max<size_t>(64, 2 * m_buffer.size()));
+    for (size_t i = 0; i < m_size; i++) {
+      buffer[i] = (*this)[i];
+    }
+    m_buffer.swap(buffer);
+    m_head = 0;
+  }
+
+private:
+  std::vector<breakEvent> m_buffer;
+  size_t m_head = 0;
+  size_t m_size = 0;
+};
+
+}  // namespace networkV4
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "Core/Network.hpp"
+#include "Misc/Config.hpp"
+
+namespace networkV4
+{
+
+// Verlet skin for break checks. A full check stores the slack of every bond
+// to its break threshold and the node positions. A bond length can change by
+// at most the sum of its end displacements, so afterwards only bonds whose
+// slack is below twice the skin are tracked, and of those only the ones whose
+// ends have moved far enough are re-checked. Once any node has moved further
+// than the skin the untracked bonds are no longer safe and a full check runs.
+class breakScreen
+{
+public:
+  breakScreen() = default;
+  breakScreen(double _skin)
+      : m_skin(_skin)
+  {
+  }
+
+public:
+  // Evaluates every bond and resets the screen, returns the number broken
+  auto fullCheck(network& _network) -> size_t
+  {
+    const size_t queued = _network.getBreakQueue().size();
+    _network.computeBreaks();
+    reset(_network);
+    m_fullChecks++;
+    return _network.getBreakQueue().size() - queued;
+  }
+
+  // Resets the screen from a network whose breaks are up to date
+  void reset(const network& _network)
+  {
+    const auto& positions = _network.getNodes().positions();
+    const auto& bonds = _network.getBonds();
+    const auto& box = _network.getBox();
+
+    m_ref = positions;
+    m_disp.assign(positions.size(), 0.0);
+    m_Lx = box.getLx();
+    m_Ly = box.getLy();
+    m_xy = box.getxy();
+
+    m_candidates.clear();
+    m_slack.clear();
+    for (size_t i = 0; i < bonds.size(); i++) {
+      const auto& bond = bonds.getBonds()[i];
+      const auto dist =
+          box.minDist(positions[bond.src], positions[bond.dst]);
+      const auto slack = bonded::visitSlack(bonds.getBreaks()[i], dist);
+      if (slack && slack.value() < 2.0 * m_skin) {
+        m_candidates.push_back(i);
+        m_slack.push_back(slack.value());
+      }
+    }
+  }
+
+  // Re-checks the bonds that may have reached their threshold since the
+  // last full check, returns the number broken
+  auto check(network& _network) -> size_t
+  {
+    const auto& positions = _network.getNodes().positions();
+    const auto& box = _network.getBox();
+    if (m_ref.size() != positions.size() || box.getLx() != m_Lx
+        || box.getLy() != m_Ly || box.getxy() != m_xy)
+    {
+      return fullCheck(_network);
+    }
+
+    double maxDisp = 0.0;
+#pragma omp parallel for schedule(static) reduction(max : maxDisp)
+    for (size_t i = 0; i < positions.size(); i++) {
+      m_disp[i] = (positions[i] - m_ref[i]).norm();
+      maxDisp = std::max(maxDisp, m_disp[i]);
+    }
+    if (maxDisp >= m_skin) {
+      return fullCheck(_network);
+    }
+
+    const auto& bonds = _network.getBonds().getBonds();
+    size_t broken = 0;
+    for (size_t c = 0; c < m_candidates.size(); c++) {
+      const auto& bond = bonds[m_candidates[c]];
+      if (m_disp[bond.src] + m_disp[bond.dst] >= m_slack[c]) {
+        m_rechecks++;
+        broken += _network.checkBreak(m_candidates[c]) ? 1 : 0;
+      }
+    }
+
+    if (config::breakScreen::validate && !validate(_network)) {
+      throw std::runtime_error("breakScreen: missed a bond over threshold");
+    }
+    return broken;
+  }
+
+  // True if no bond is over its threshold, a full scan for validation
+  auto validate(const network& _network) const -> bool
+  {
+    const auto& positions = _network.getNodes().positions();
+    const auto& bonds = _network.getBonds();
+    const auto& box = _network.getBox();
+    for (size_t i = 0; i < bonds.size(); i++) {
+      const auto& bond = bonds.getBonds()[i];
+      const auto dist =
+          box.minDist(positions[bond.src], positions[bond.dst]);
+      if (bonded::visitBreak(bonds.getBreaks()[i], dist)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  auto getFullChecks() const -> size_t { return m_fullChecks; }
+  auto getRechecks() const -> size_t { return m_rechecks; }
+
+private:
+  double m_skin = config::breakScreen::skin;
+
+  std::vector<Utils::Math::vec2d> m_ref;
+  std::vector<double> m_disp;
+  double m_Lx = 0.0;
+  double m_Ly = 0.0;
+  double m_xy = 0.0;
+
+  std::vector<size_t> m_candidates;
+  std::vector<double> m_slack;
+
+  size_t m_fullChecks = 0;
+  size_t m_rechecks = 0;
+};
+
+}  // namespace networkV4
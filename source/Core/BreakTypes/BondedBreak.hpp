@@ -36,5 +36,13 @@ inline auto visitData(const networkV4::bonded::breakTypes& _break,
                     _break);
 }
 
+inline auto visitSlack(const networkV4::bonded::breakTypes& _break,
+                       const Utils::Math::vec2d& _dist) -> std::optional<double>
+{
+  return std::visit([_dist](const auto& _break) -> std::optional<double>
+                    { return _break.slack(_dist); },
+                    _break);
+}
+
 }  // namespace bonded
 }  // namespace networkV4
\ No newline at end of file
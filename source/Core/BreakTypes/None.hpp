@@ -20,6 +20,10 @@ public:
     return {};
   }
   std::optional<double> data(const Utils::Math::vec2d& _r) const { return {}; }
+  std::optional<double> slack(const Utils::Math::vec2d& _r) const
+  {
+    return {};
+  }
 };
 }  // namespace BreakTypes
 }  // namespace networkV4
\ No newline at end of file
@@ -38,6 +38,11 @@ public:
   {
     return (_r.norm() * m_invR0) - 1.0;
   }
+  // Change in length before the bond breaks
+  std::optional<double> slack(const Utils::Math::vec2d& _r) const
+  {
+    return m_r0 * (1.0 + m_lambda) - _r.norm();
+  }
 
 private:
   double m_r0;  // equilibrium bond length
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <variant>
+#include <vector>
+
+#include "Core/Bonds.hpp"
+
+namespace networkV4
+{
+
+// Connected components of the nodes over the live bonds. They are found once
+// with a union-find, then kept up to date as bonds break: a break only marks
+// its component, which is split by a search over its own nodes on the next
+// refresh. A node without live bonds is a component of its own.
+class components
+{
+public:
+  components() = default;
+
+public:
+  // Finds the components from scratch
+  void rebuild(const bonded::bonds& _bonds, size_t _nodes)
+  {
+    const auto& bonds = _bonds.getBonds();
+    const auto& types = _bonds.getTypes();
+    const size_t B = bonds.size();
+
+    m_nodes = _nodes;
+    m_bonds.assign(bonds.begin(), bonds.end());
+    m_live.resize(B);
+    for (size_t i = 0; i < B; i++) {
+      m_live[i] = !std::holds_alternative<Forces::VirtualBond>(types[i]);
+    }
+
+    // Bonds of each node, in both directions
+    m_offsets.assign(m_nodes + 1, 0);
+    for (const auto& bond : m_bonds) {
+      m_offsets[bond.src + 1]++;
+      m_offsets[bond.dst + 1]++;
+    }
+    std::partial_sum(m_offsets.begin(), m_offsets.end(), m_offsets.begin());
+    m_adjacent.resize(m_offsets.back());
+    std::vector<size_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+    for (size_t i = 0; i < B; i++) {
+      m_adjacent[fill[m_bonds[i].src]++] = i;
+      m_adjacent[fill[m_bonds[i].dst]++] = i;
+    }
+
+    std::vector<size_t> parent(m_nodes);
+    std::vector<size_t> rank(m_nodes, 1);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&](size_t _n)
+    {
+      while (parent[_n] != _n) {
+        parent[_n] = parent[parent[_n]];
+        _n = parent[_n];
+      }
+      return _n;
+    };
+    for (size_t i = 0; i < B; i++) {
+      if (!m_live[i]) {
+        continue;
+      }
+      size_t a = find(m_bonds[i].src);
+      size_t b = find(m_bonds[i].dst);
+      if (a == b) {
+        continue;
+      }
+      if (rank[a] < rank[b]) {
+        std::swap(a, b);
+      }
+      parent[b] = a;
+      rank[a] += rank[b];
+    }
+
+    m_label.assign(m_nodes, NONE);
+    m_members.clear();
+    for (size_t n = 0; n < m_nodes; n++) {
+      const size_t root = find(n);
+      if (m_label[root] == NONE) {
+        m_label[root] = m_members.size();
+        m_members.emplace_back();
+      }
+      m_label[n] = m_label[root];
+      m_members[m_label[n]].push_back(n);
+    }
+    m_dirty.clear();
+  }
+
+  // Bond _index broke, its component may have split
+  void recordBreak(size_t _index)
+  {
+    if (_index < m_live.size() && m_live[_index]) {
+      m_live[_index] = 0;
+      m_dirty.push_back(m_label[m_bonds[_index].src]);
+    }
+  }
+
+  // Splits the components marked by breaks since the last refresh
+  void refresh()
+  {
+    if (m_dirty.empty()) {
+      return;
+    }
+    std::sort(m_dirty.begin(), m_dirty.end());
+    m_dirty.erase(std::unique(m_dirty.begin(), m_dirty.end()), m_dirty.end());
+    for (const size_t c : m_dirty) {
+      split(c);
+    }
+    m_dirty.clear();
+  }
+
+  // Number of bonds and nodes at the last rebuild
+  auto size() const -> size_t { return m_bonds.size(); }
+  auto nodes() const -> size_t { return m_nodes; }
+
+  auto count() const -> size_t { return m_members.size(); }
+  auto label(size_t _node) const -> size_t { return m_label[_node]; }
+  auto members(size_t _component) const -> const std::vector<size_t>&
+  {
+    return m_members[_component];
+  }
+
+  // Live bonds within _component, in bond order
+  auto liveBonds(size_t _component) const -> std::vector<size_t>
+  {
+    std::vector<size_t> bonds;
+    for (const size_t n : m_members[_component]) {
+      for (size_t j = m_offsets[n]; j < m_offsets[n + 1]; j++) {
+        const size_t i = m_adjacent[j];
+        if (m_live[i] && m_bonds[i].src == n) {
+          bonds.push_back(i);
+        }
+      }
+    }
+    std::sort(bonds.begin(), bonds.end());
+    return bonds;
+  }
+
+private:
+  // Relabels the nodes of _component by search, the part holding its first
+  // node keeps the label and every other part is appended
+  void split(size_t _component)
+  {
+    const std::vector<size_t> nodes = std::move(m_members[_component]);
+    m_members[_component].clear();
+    for (const size_t n : nodes) {
+      m_label[n] = NONE;
+    }
+
+    std::vector<size_t> stack;
+    size_t label = _component;
+    for (const size_t start : nodes) {
+      if (m_label[start] != NONE) {
+        continue;
+      }
+      if (label != _component || !m_members[_component].empty()) {
+        label = m_members.size();
+        m_members.emplace_back();
+      }
+      m_label[start] = label;
+      stack.push_back(start);
+      while (!stack.empty()) {
+        const size_t n = stack.back();
+        stack.pop_back();
+        m_members[label].push_back(n);
+        for (size_t j = m_offsets[n]; j < m_offsets[n + 1]; j++) {
+          const size_t i = m_adjacent[j];
+          if (!m_live[i]) {
+            continue;
+          }
+          const size_t other =
+              m_bonds[i].src == n ? m_bonds[i].dst : m_bonds[i].src;
+          if (m_label[other] == NONE) {
+            m_label[other] = label;
+            stack.push_back(other);
+          }
+        }
+      }
+      std::sort(m_members[label].begin(), m_members[label].end());
+    }
+  }
+
+private:
+  static constexpr size_t NONE = static_cast<size_t>(-1);
+
+  size_t m_nodes = 0;
+  std::vector<bonded::BondInfo> m_bonds;
+  std::vector<char> m_live;
+  std::vector<size_t> m_offsets;  // into m_adjacent, per node
+  std::vector<size_t> m_adjacent;  // bond indices
+
+  std::vector<size_t> m_label;  // per node
+  std::vector<std::vector<size_t>> m_members;  // per component, sorted
+  std::vector<size_t> m_dirty;  // components that lost a bond
+};
+
+}  // namespace networkV4
@@ -4,6 +4,7 @@
 
 #include "Core/Forces/Harmonic.hpp"
 #include "Core/Forces/Virtual.hpp"
+#include "Misc/Math/Matrix.hpp"
 
 namespace networkV4
 {
@@ -45,5 +46,30 @@ inline auto visitEnergy(const networkV4::bonded::bondTypes& _bond,
                     _bond);
 }
 
+inline auto visitHessian(const networkV4::bonded::bondTypes& _bond,
+                         const Utils::Math::vec2d& _dist,
+                         const Utils::Math::vec2d& _dv)
+    -> std::optional<Utils::Math::vec2d>
+{
+  return std::visit([&_dist, &_dv](const auto& _bond)
+                        -> std::optional<Utils::Math::vec2d>
+                    { return _bond.hessian(_dist, _dv); },
+                    _bond);
+}
+
+// 2x2 bond stiffness block d2U/ddist2, assembled from Hessian products
+inline auto visitStiffness(const networkV4::bonded::bondTypes& _bond,
+                           const Utils::Math::vec2d& _dist)
+    -> std::optional<Utils::Math::mat22d>
+{
+  const auto Kx = visitHessian(_bond, _dist, {1.0, 0.0});
+  const auto Ky = visitHessian(_bond, _dist, {0.0, 1.0});
+  if (!Kx || !Ky) {
+    return std::nullopt;
+  }
+  return Utils::Math::mat22d(
+      {Kx.value()[0], Ky.value()[0], Kx.value()[1], Ky.value()[1]});
+}
+
 }  // namespace bonded
 }  // namespace networkV4
\ No newline at end of file
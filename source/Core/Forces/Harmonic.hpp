@@ -14,6 +14,7 @@ class HarmonicBond
 public:
   HarmonicBond(double _k, double _r0, bool _normalized = false)
       : m_k(_k)
+      , m_baseK(_k)
       , m_r0(_r0)
       , m_normalized(_normalized)
   {
@@ -29,6 +30,8 @@ public:
   const double k() const { return m_normalized ? m_k * m_r0 : m_k; }
   const double r0() const { return m_r0; }
   const bool normalized() const { return m_normalized; }
+  // Spring constant as given, before normalisation by r0
+  const double baseK() const { return m_baseK; }
 
 public:
   std::optional<Utils::Math::vec2d> force(const Utils::Math::vec2d& _dx) const
@@ -49,9 +52,24 @@ public:
     const auto dr = r - m_r0;
     return 0.5 * m_k * dr * dr;
   }
+  // Product of the bond Hessian with the relative displacement _dv,
+  // K = k [n n^T + (1 - r0 / r) (I - n n^T)]
+  std::optional<Utils::Math::vec2d> hessian(const Utils::Math::vec2d& _dx,
+                                            const Utils::Math::vec2d& _dv) const
+  {
+    const auto r = _dx.norm();
+    if (r < ROUND_ERROR_PRECISION) {
+      throw("HarmonicBond::hessian: r is too small");
+    }
+    const auto n = _dx / r;
+    const auto ndotv = n * _dv;
+    const auto tension = 1.0 - m_r0 / r;
+    return m_k * (tension * _dv + (1.0 - tension) * ndotv * n);
+  }
 
 private:
   double m_k;  // spring constant
+  double m_baseK;  // spring constant as given
   double m_r0;  // equilibrium bond length
   bool m_normalized = false;  // whether the spring constant is normalized
 };
@@ -20,6 +20,11 @@ public:
     return {};
   }
   std::optional<double> energy(const Utils::Math::vec2d& _dx) const { return {}; }
+  std::optional<Utils::Math::vec2d> hessian(const Utils::Math::vec2d& _dx,
+                                            const Utils::Math::vec2d& _dv) const
+  {
+    return {};
+  }
 };
 }  // namespace Forces
 }  // namespace networkV4
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include <filesystem>
 #include <fstream>
 #include <numeric>
+#include <optional>
+#include <utility>
 #include <vector>
 
 #include "Network.hpp"
@@ -10,8 +12,10 @@
 #include <range/v3/algorithm.hpp>
 #include <range/v3/view/zip.hpp>
 
+#include "Core/BondQuery.hpp"
 #include "Core/Bonds.hpp"
 #include "Core/Nodes.hpp"
+#include "Misc/Hash.hpp"
 #include "Misc/Math/Tensor2.hpp"
 #include "Misc/Math/Vector.hpp"
 
@@ -84,16 +88,67 @@ auto networkV4::network::getStresses() const -> const stresses&
   return m_stresses;
 }
 
-auto networkV4::network::getBreakQueue() -> bondQueue&
+auto networkV4::network::getBreakQueue() -> breakLog&
 {
   return m_breakQueue;
 }
 
-auto networkV4::network::getBreakQueue() const -> const bondQueue&
+auto networkV4::network::getBreakQueue() const -> const breakLog&
 {
   return m_breakQueue;
 }
 
+void networkV4::network::setClock(double _strain, double _time)
+{
+  m_clockStrain = _strain;
+  m_clockTime = _time;
+}
+
+auto networkV4::network::getBrokenHash() const -> std::uint64_t
+{
+  return m_brokenHash;
+}
+
+auto networkV4::network::getStats() const -> const bondStats&
+{
+  if (m_cacheState.stats != m_bonds.structure()) {
+    m_stats.rebuild(m_bonds);
+    m_cacheState.stats = m_bonds.structure();
+  }
+  return m_stats;
+}
+
+auto networkV4::network::getClasses() const -> const bondClasses&
+{
+  if (m_cacheState.classes != m_bonds.structure()) {
+    m_classes.rebuild(m_bonds);
+    m_cacheState.classes = m_bonds.structure();
+  }
+  m_classes.compact();
+  return m_classes;
+}
+
+auto networkV4::network::getParams() const -> const bondParams&
+{
+  if (m_cacheState.params != m_bonds.structure()) {
+    m_params.rebuild(m_bonds);
+    m_cacheState.params = m_bonds.structure();
+  }
+  return m_params;
+}
+
+auto networkV4::network::getComponents() const -> const components&
+{
+  if (m_cacheState.components != m_bonds.structure()
+      || m_components.nodes() != m_nodes.size())
+  {
+    m_components.rebuild(m_bonds, m_nodes.size());
+    m_cacheState.components = m_bonds.structure();
+  }
+  m_components.refresh();
+  return m_components;
+}
+
 double networkV4::network::getShearStrain() const
 {
   return m_box.shearStrain();
@@ -108,6 +163,7 @@ auto networkV4::network::getElongationStrain() const -> Utils::Math::vec2d
 
 void networkV4::network::shear(double _step)
 {
+  m_boxGen++;
   double dxy = _step * m_box.getLy();
   m_box.setxy(m_box.getxy() + dxy);
   std::transform(m_nodes.positions().begin(),
@@ -119,6 +175,7 @@ void networkV4::network::shear(double _step)
 
 void networkV4::network::setBox(const box& _box)
 {
+  m_boxGen++;
   std::transform(m_nodes.positions().begin(),
                  m_nodes.positions().end(),
                  m_nodes.positions().begin(),
@@ -137,21 +194,113 @@ void networkV4::network::wrapNodes()
   }
 }
 
+void networkV4::network::invalidateForces()
+{
+  m_forceState.valid = false;
+}
+
+auto networkV4::network::getForceEvaluations() const -> size_t
+{
+  return m_forceEvals;
+}
+
+auto networkV4::network::getAvoidedEvaluations() const -> size_t
+{
+  return m_avoidedEvals;
+}
+
+auto networkV4::network::getBreakKeys() const -> const breakKeys&
+{
+  return m_breakKeys;
+}
+
+auto networkV4::network::breakKeysCurrent() const -> bool
+{
+  return m_keyState.valid
+      && m_keyState.positions == m_nodes.positionGeneration()
+      && m_keyState.box == m_boxGen && m_keyState.bonds == m_bonds.generation();
+}
+
+void networkV4::network::setContext(
+    std::shared_ptr<const OMP::context> _context)
+{
+  if (!_context) {
+    throw std::runtime_error("network::setContext: no context");
+  }
+  m_context = std::move(_context);
+}
+
+auto networkV4::network::getContext() const -> const OMP::context&
+{
+  return *m_context;
+}
+
+auto networkV4::network::forcesCurrent(bool _evalBreak, bool _evalStress) const
+    -> bool
+{
+  return m_forceState.valid && (m_forceState.breaks || !_evalBreak)
+      && (m_forceState.stress || !_evalStress)
+      && m_forceState.positions == m_nodes.positionGeneration()
+      && m_forceState.box == m_boxGen
+      && m_forceState.bonds == m_bonds.generation();
+}
+
+// Breaks found during the evaluation are already reflected in the forces, so
+// the bond generation is read after it
+void networkV4::network::recordForces(bool _evalBreak, bool _evalStress)
+{
+  m_forceEvals++;
+  m_forceState = {true,
+                  _evalBreak,
+                  _evalStress,
+                  m_nodes.positionGeneration(),
+                  m_boxGen,
+                  m_bonds.generation()};
+  if (_evalBreak || _evalStress) {
+    m_keyState = m_forceState;
+  }
+}
+
+auto networkV4::network::recordKeys(size_t _index,
+                                    const Utils::Math::vec2d& _dist,
+                                    const bonded::breakTypes& _break) -> bool
+{
+  return m_breakKeys.set(
+      _index,
+      bonded::visitThreshold(_break, _dist).value_or(breakKeys::LOWEST),
+      bonded::visitData(_break, _dist).value_or(breakKeys::LOWEST));
+}
+
 #if not defined(_OPENMP)
 template<bool _evalBreak, bool _evalStress>
 void networkV4::network::computeForces()
 {
+  if (forcesCurrent(_evalBreak, _evalStress)) {
+    m_avoidedEvals++;
+    return;
+  }
+
   m_energy = 0.0;
   m_stresses.zero();
   m_nodes.zeroForce();
 
-  const auto& positions = m_nodes.positions();
+  const auto& positions = std::as_const(m_nodes).positions();
+  const auto& bonds = std::as_const(m_bonds).getBonds();
+  auto& types = m_bonds.getTypes();
+  auto& breaks = m_bonds.getBreaks();
+  auto& tags = m_bonds.getTags();
+  const auto& classIds = getClasses().classIds();
+  const bool table = BOND_PARAM_TABLE && getParams().usable();
+  classStresses classStress {};
+  if constexpr (_evalBreak || _evalStress) {
+    m_breakKeys.begin(bonds.size());
+  }
+
+  for (size_t i = 0; i < bonds.size(); i++) {
+    const auto& bond = bonds[i];
+    auto& type = types[i];
+    auto& brk = breaks[i];
 
-  for (auto&& [bond, type, brk, tags] : ranges::views::zip(m_bonds.getBonds(),
-                                                           m_bonds.getTypes(),
-                                                           m_bonds.getBreaks(),
-                                                           m_bonds.getTags()))
-  {
     // TODO: This doesn't need to be done if we are not evaluating breaks, or
     // type is virtual
     // TODO: could this be done with a list of active bonds? Could add a type
@@ -167,19 +316,36 @@ void networkV4::network::computeForces()
     const auto dist = m_box.minDist(pos1, pos2);
 
     if constexpr (_evalBreak) {
-      evalBreak(dist, bond, type, brk, tags);
+      evalBreak(dist, i, bond, type, brk, tags[i]);
+    }
+    if constexpr (_evalBreak || _evalStress) {
+      if (recordKeys(i, dist, brk)) {
+        m_breakKeys.changed(i);
+      }
     }
 
-    const auto force = bonded::visitForce(type, dist);
-    if (force) {
-      applyforce<_evalStress>(bond, dist, force.value(), tags);
+    std::optional<Utils::Math::vec2d> force;
+    std::optional<double> energy;
+    if (table) {
+      std::tie(force, energy) = m_params.evaluate(i, dist);
+    } else {
+      force = bonded::visitForce(type, dist);
+      energy = bonded::visitEnergy(type, dist);
     }
 
-    const auto energy = bonded::visitEnergy(type, dist);
+    if (force) {
+      applyforce<_evalStress>(
+          bond, dist, force.value(), classStress[classIds[i]]);
+    }
     if (energy) {
       m_energy += energy.value();
     }
   }
+
+  if constexpr (_evalStress) {
+    m_stresses.distribute(classStress);
+  }
+  recordForces(_evalBreak, _evalStress);
 }
 
 // Explicit template instantiation
@@ -187,51 +353,201 @@ template void networkV4::network::computeForces<false, false>();
 template void networkV4::network::computeForces<true, false>();
 template void networkV4::network::computeForces<false, true>();
 template void networkV4::network::computeForces<true, true>();
-#endif
 
-auto networkV4::network::computeEnergy() -> double
+void networkV4::network::computeHessianProduct(
+    const std::vector<Utils::Math::vec2d>& _v,
+    std::vector<Utils::Math::vec2d>& _Hv) const
 {
-  m_energy = 0.0;
+  _Hv.assign(_v.size(), Utils::Math::vec2d({0.0, 0.0}));
+
+  const auto& positions = m_nodes.positions();
   for (const auto [bond, type] :
        ranges::views::zip(m_bonds.getBonds(), m_bonds.getTypes()))
   {
-    const auto& pos1 = m_nodes.positions()[bond.src];
-    const auto& pos2 = m_nodes.positions()[bond.dst];
+    const auto& pos1 = positions[bond.src];
+    const auto& pos2 = positions[bond.dst];
     const auto dist = m_box.minDist(pos1, pos2);
 
-    const auto energy = bonded::visitEnergy(type, dist);
-    if (energy) {
-      m_energy += energy.value();
+    const auto Hv =
+        bonded::visitHessian(type, dist, _v[bond.src] - _v[bond.dst]);
+    if (Hv) {
+      _Hv[bond.src] += Hv.value();
+      _Hv[bond.dst] -= Hv.value();
     }
   }
-  return m_energy;
 }
+#endif
 
-void networkV4::network::computeBreaks()
+auto networkV4::network::assembleHessian() const -> Utils::Math::csrMatrix
 {
-  for (const auto& [bond, type, brk, tags] :
-       ranges::views::zip(m_bonds.getBonds(),
-                          m_bonds.getTypes(),
-                          m_bonds.getBreaks(),
-                          m_bonds.getTags()))
+  const auto& positions = m_nodes.positions();
+  const auto& bonds = m_bonds.getBonds();
+  const auto& types = m_bonds.getTypes();
+  const size_t N = m_nodes.size();
+
+  std::vector<std::optional<Utils::Math::mat22d>> blocks(bonds.size());
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < bonds.size(); i++) {
+    const auto dist =
+        m_box.minDist(positions[bonds[i].src], positions[bonds[i].dst]);
+    blocks[i] = bonded::visitStiffness(types[i], dist);
+  }
+
+  // node to bond incidence, so each thread owns whole rows
+  std::vector<size_t> incidencePtr(N + 1, 0);
+  for (const auto& bond : bonds) {
+    incidencePtr[bond.src + 1]++;
+    incidencePtr[bond.dst + 1]++;
+  }
+  std::partial_sum(
+      incidencePtr.begin(), incidencePtr.end(), incidencePtr.begin());
+  std::vector<size_t> incidence(incidencePtr[N]);
   {
-    const auto& pos1 = m_nodes.positions()[bond.src];
-    const auto& pos2 = m_nodes.positions()[bond.dst];
-    const auto dist = m_box.minDist(pos1, pos2);
+    auto next = incidencePtr;
+    for (size_t i = 0; i < bonds.size(); i++) {
+      incidence[next[bonds[i].src]++] = i;
+      incidence[next[bonds[i].dst]++] = i;
+    }
+  }
+
+  std::vector<std::vector<size_t>> neighbours(N);
+  std::vector<size_t> rowPtr(2 * N + 1, 0);
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < N; i++) {
+    auto& row = neighbours[i];
+    row.push_back(i);
+    for (size_t p = incidencePtr[i]; p < incidencePtr[i + 1]; p++) {
+      const auto& bond = bonds[incidence[p]];
+      if (blocks[incidence[p]]) {
+        row.push_back(bond.src == i ? bond.dst : bond.src);
+      }
+    }
+    std::sort(row.begin(), row.end());
+    row.erase(std::unique(row.begin(), row.end()), row.end());
+    rowPtr[2 * i + 1] = 2 * row.size();
+    rowPtr[2 * i + 2] = 2 * row.size();
+  }
+  std::partial_sum(rowPtr.begin(), rowPtr.end(), rowPtr.begin());
+
+  Utils::Math::csrMatrix hessian(
+      2 * N, rowPtr, std::vector<size_t>(rowPtr.back()));
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < N; i++) {
+    for (size_t dim = 0; dim < 2; dim++) {
+      size_t p = hessian.rowPtr[2 * i + dim];
+      for (const auto j : neighbours[i]) {
+        hessian.cols[p++] = 2 * j;
+        hessian.cols[p++] = 2 * j + 1;
+      }
+    }
+
+    for (size_t p = incidencePtr[i]; p < incidencePtr[i + 1]; p++) {
+      const auto& block = blocks[incidence[p]];
+      if (!block) {
+        continue;
+      }
+      const auto& bond = bonds[incidence[p]];
+      const size_t j = bond.src == i ? bond.dst : bond.src;
+      for (size_t a = 0; a < 2; a++) {
+        for (size_t b = 0; b < 2; b++) {
+          hessian.add(2 * i + a, 2 * i + b, block.value()(a, b));
+          hessian.add(2 * i + a, 2 * j + b, -block.value()(a, b));
+        }
+      }
+    }
+  }
+  return hessian;
+}
 
-    evalBreak(dist, bond, type, brk, tags);
+auto networkV4::network::computeStrainDerivatives(
+    const Utils::Math::mat22d& _E, std::vector<Utils::Math::vec2d>& _xi) const
+    -> std::pair<double, double>
+{
+  _xi.assign(m_nodes.size(), Utils::Math::vec2d({0.0, 0.0}));
+  double dU = 0.0;
+  double d2U = 0.0;
+
+  const auto& positions = m_nodes.positions();
+  for (const auto [bond, type] :
+       ranges::views::zip(m_bonds.getBonds(), m_bonds.getTypes()))
+  {
+    const auto dist =
+        m_box.minDist(positions[bond.src], positions[bond.dst]);
+    const auto force = bonded::visitForce(type, dist);
+    if (!force) {
+      continue;
+    }
+    const Utils::Math::vec2d Ed({_E(0, 0) * dist[0] + _E(0, 1) * dist[1],
+                                 _E(1, 0) * dist[0] + _E(1, 1) * dist[1]});
+    const auto KEd = bonded::visitHessian(type, dist, Ed).value();
+
+    // force is -dU/ddist, the prestress term of Xi is E^T dU/ddist
+    const auto& f = force.value();
+    const Utils::Math::vec2d prestress({-(_E(0, 0) * f[0] + _E(1, 0) * f[1]),
+                                        -(_E(0, 1) * f[0] + _E(1, 1) * f[1])});
+    dU -= f * Ed;
+    d2U += Ed * KEd;
+    _xi[bond.src] += KEd + prestress;
+    _xi[bond.dst] -= KEd + prestress;
+  }
+  return {dU, d2U};
+}
+
+auto networkV4::network::computeEnergy() -> double
+{
+  const auto& types = std::as_const(m_bonds).getTypes();
+  m_energy = query::scan(*this,
+                         {},
+                         [&](size_t _index, const Utils::Math::vec2d& _dist)
+                         { return bonded::visitEnergy(types[_index], _dist); },
+                         query::sum {})
+                 .value;
+  return m_energy;
+}
+
+// The bonds are checked in parallel and broken in index order, so the break
+// queue matches a serial sweep
+void networkV4::network::computeBreaks()
+{
+  const auto& breaks = std::as_const(m_bonds).getBreaks();
+  const auto broken = query::scan(
+      *this,
+      {},
+      [&](size_t _index, const Utils::Math::vec2d& _dist)
+          -> std::optional<double>
+      {
+        if (!bonded::visitBreak(breaks[_index], _dist)) {
+          return std::nullopt;
+        }
+        return 1.0;
+      },
+      query::collect {});
+  for (const auto index : broken.indices) {
+    checkBreak(index);
   }
 }
 
 void networkV4::network::evalBreak(const Utils::Math::vec2d& _dist,
+                                   size_t _index,
                                    const bonded::BondInfo& _binfo,
                                    bonded::bondTypes& _type,
                                    bonded::breakTypes& _break,
                                    Utils::Tags::tagFlags& _tags)
 {
-  const bool broken = bonded::visitBreak(_break, _dist);
+  const bool broken = BOND_PARAM_TABLE && getParams().usable()
+      ? m_params.breaks(_index, _dist)
+      : bonded::visitBreak(_break, _dist);
   if (broken) {
-    m_breakQueue.emplace_back(_binfo, _type, _break, _tags);
+    const auto event = breakEvent::from(_index,
+                                        m_bonds.getIds()[_index],
+                                        _binfo,
+                                        _type,
+                                        _break,
+                                        _tags,
+                                        m_clockStrain,
+                                        m_clockTime);
+    m_breakQueue.push_back(event);
+    recordBreak(event);
 
     _type = Forces::VirtualBond {};
     _break = BreakTypes::None {};
@@ -240,19 +556,67 @@ void networkV4::network::evalBreak(const Utils::Math::vec2d& _dist,
   }
 }
 
+void networkV4::network::breakBond(size_t _index)
+{
+  const bool keysCurrent = breakKeysCurrent();
+  recordBreak(makeBreakEvent(_index));
+  m_bonds.getTypes()[_index] = Forces::VirtualBond {};
+  m_bonds.getBreaks()[_index] = BreakTypes::None {};
+  m_bonds.getTags()[_index].set(BROKEN_TAG_INDEX);
+  m_breakKeys.recordBreak(_index);
+  if (keysCurrent) {
+    m_keyState.bonds = m_bonds.generation();
+  }
+}
+
+auto networkV4::network::makeBreakEvent(size_t _index) const -> breakEvent
+{
+  return breakEvent::from(_index,
+                          m_bonds.getIds()[_index],
+                          m_bonds.getBonds()[_index],
+                          m_bonds.getTypes()[_index],
+                          m_bonds.getBreaks()[_index],
+                          m_bonds.getTags()[_index],
+                          m_clockStrain,
+                          m_clockTime);
+}
+
+auto networkV4::network::checkBreak(size_t _index) -> bool
+{
+  const auto& bond = m_bonds.getBonds()[_index];
+  const auto dist = m_box.minDist(m_nodes.positions()[bond.src],
+                                  m_nodes.positions()[bond.dst]);
+  const size_t queued = m_breakQueue.size();
+  evalBreak(dist,
+            _index,
+            bond,
+            m_bonds.getTypes()[_index],
+            m_bonds.getBreaks()[_index],
+            m_bonds.getTags()[_index]);
+  return m_breakQueue.size() > queued;
+}
+
+void networkV4::network::recordBreak(const breakEvent& _event)
+{
+  m_brokenHash ^= Utils::Hash::mix(_event.bond);
+  m_stats.recordBreak(_event.live, _event.tags);
+  m_classes.recordBreak(_event.position, _event.tags);
+  m_params.recordBreak(_event.position);
+  m_components.recordBreak(_event.position);
+}
+
 template<bool _evalStress>
 void networkV4::network::applyforce(const bonded::BondInfo& _binfo,
                                     const Utils::Math::vec2d& _dist,
                                     const Utils::Math::vec2d& _force,
-                                    const Utils::Tags::tagFlags& _tags)
+                                    Utils::tensor2d& _classStress)
 {
   auto& forces = m_nodes.forces();
   forces[_binfo.src] += _force;
   forces[_binfo.dst] -= _force;
 
   if constexpr (_evalStress) {
-    const auto stress =
+    _classStress +=
         Utils::Math::tensorProduct(_force, -_dist) * m_box.invArea();
-    m_stresses.distribute(stress, _tags);
   }
 }
\ No newline at end of file
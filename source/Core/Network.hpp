@@ -1,24 +1,31 @@
 #pragma once
 
-#include <deque>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <utility>
 #include <vector>
 
+#include "Core/BondClasses.hpp"
+#include "Core/BondParams.hpp"
+#include "Core/BondStats.hpp"
 #include "Core/Bonds.hpp"
+#include "Core/Components.hpp"
+#include "Core/BreakKeys.hpp"
+#include "Core/BreakLog.hpp"
 #include "Core/Nodes.hpp"
+#include "Core/OMP/OMP.hpp"
 #include "Core/Stresses.hpp"
 #include "Core/box.hpp"
 #include "Misc/Tags/TagMap.hpp"
 #include "Misc/Tags/TagStorage.hpp"
+#include "Misc/Math/Sparse.hpp"
 #include "Misc/Math/Tensor2.hpp"
 #include "Misc/Math/Vector.hpp"
 
 namespace networkV4
 {
 
-using breakInfo = std::tuple<bonded::BondInfo, bonded::bondTypes, bonded::breakTypes, Utils::Tags::tagFlags>;
-using bondQueue = std::deque<breakInfo>;
-
 class network
 {
 public:
@@ -48,8 +55,44 @@ public:
   auto getStresses() const -> const stresses&;
 
   auto getBreakQueue()
-      -> bondQueue&;  // TODO: make so Input and intergrators can access nodes
-  auto getBreakQueue() const -> const bondQueue&;
+      -> breakLog&;  // TODO: make so Input and intergrators can access nodes
+  auto getBreakQueue() const -> const breakLog&;
+
+  // Strain and time stamped on the break events found from now on
+  void setClock(double _strain, double _time);
+
+  // Order independent hash of the set of bonds broken so far
+  auto getBrokenHash() const -> std::uint64_t;
+
+  // The bond caches below are rebuilt when bonds::structure changes, so
+  // edits other than breaks must call bonds::invalidate
+
+  // Live, broken and per tag bond counts, counted once then kept up to date
+  // as bonds break
+  auto getStats() const -> const bondStats&;
+
+  // Bonds grouped by tag class, built once then updated as bonds break
+  auto getClasses() const -> const bondClasses&;
+
+  // Deduplicated bond parameters, built once then updated as bonds break
+  auto getParams() const -> const bondParams&;
+
+  // Connected components over the live bonds, found once then split as bonds
+  // break
+  auto getComponents() const -> const components&;
+
+  // Break keys of the last pass that evaluated breaks or stresses, see
+  // breakKeysCurrent for whether they still hold
+  auto getBreakKeys() const -> const breakKeys&;
+
+  // True if the positions, box and bonds are unchanged since the break keys
+  // were recorded, breakBond keeps them current
+  auto breakKeysCurrent() const -> bool;
+
+  // Partitions and team size of the force loops, shared with copies. Without
+  // partitions the OMP loops take all bonds as one partition.
+  void setContext(std::shared_ptr<const OMP::context> _context);
+  auto getContext() const -> const OMP::context&;
 
 public:
   double getShearStrain() const;
@@ -61,29 +104,74 @@ public:
   void wrapNodes();
 
 public:
+  // Does nothing if the positions, box and bonds are unchanged since the last
+  // evaluation and it evaluated at least the requested breaks and stresses
   template <bool _evalBreak = false, bool _evalStress = false>
   void computeForces();
 
+  // Makes the next computeForces evaluate regardless
+  void invalidateForces();
+
+  auto getForceEvaluations() const -> size_t;
+  auto getAvoidedEvaluations() const -> size_t;
+
   auto computeEnergy() -> double;
   void computeBreaks();
 
+  // Converts bond _index to a virtual bond and tags it as broken
+  void breakBond(size_t _index);
+
+  // Event for bond _index breaking now, from its current parameters
+  auto makeBreakEvent(size_t _index) const -> breakEvent;
+
+  // Evaluates the break criterion of bond _index alone, queueing it if broken
+  auto checkBreak(size_t _index) -> bool;
+
+  // _Hv = H _v, where H is the Hessian of the energy at the current positions
+  void computeHessianProduct(const std::vector<Utils::Math::vec2d>& _v,
+                             std::vector<Utils::Math::vec2d>& _Hv) const;
+
+  // Sparse Hessian at the current positions, dof 2 * node + dim
+  auto assembleHessian() const -> Utils::Math::csrMatrix;
+
+  // Derivatives along the affine deformation x -> (I + eps _E) x. Returns
+  // dU/deps and the affine d2U/deps2, and sets _xi = d2U/dx deps.
+  auto computeStrainDerivatives(const Utils::Math::mat22d& _E,
+                                std::vector<Utils::Math::vec2d>& _xi) const
+      -> std::pair<double, double>;
+
 private:
   void evalBreak(const Utils::Math::vec2d& _dist,
+                 size_t _index,
                  const bonded::BondInfo& _binfo,
                  bonded::bondTypes& _type,
                  bonded::breakTypes& _break,
                  Utils::Tags::tagFlags& _tags);
 
+  void recordBreak(const breakEvent& _event);
+
+  // Sets the break keys of bond _index at _dist, true if they changed
+  auto recordKeys(size_t _index,
+                  const Utils::Math::vec2d& _dist,
+                  const bonded::breakTypes& _break) -> bool;
+
+  auto forcesCurrent(bool _evalBreak, bool _evalStress) const -> bool;
+  void recordForces(bool _evalBreak, bool _evalStress);
+
   template <bool _evalBreak = false>
   void applyforce(const bonded::BondInfo& _binfo,
                   const Utils::Math::vec2d& _dist,
                   const Utils::Math::vec2d& _force,
-                    const Utils::Tags::tagFlags& _tags);
+                  Utils::tensor2d& _classStress);
 
 #if defined(_OPENMP)
 private:
   template <bool _evalBreak = false, bool _evalStress = false>
   void computePass(auto _parts);
+
+  void computeHessianPass(auto _parts,
+                          const std::vector<Utils::Math::vec2d>& _v,
+                          std::vector<Utils::Math::vec2d>& _Hv) const;
 #endif
 
 private:
@@ -96,16 +184,47 @@ private:
   nodes m_nodes;
   bonded::bonds m_bonds;
 
-  bondQueue m_breakQueue;
+  breakLog m_breakQueue;
+  double m_clockStrain = 0.0;
+  double m_clockTime = 0.0;
+  std::uint64_t m_brokenHash = 0;
+  mutable bondStats m_stats;
+  mutable bondClasses m_classes;
+  mutable bondParams m_params;
+  mutable components m_components;
+
+  // Bond structure the caches above were built at, see bonds::structure
+  struct cacheState
+  {
+    std::uint64_t stats = 0;
+    std::uint64_t classes = 0;
+    std::uint64_t params = 0;
+    std::uint64_t components = 0;
+  };
+  mutable cacheState m_cacheState;
+
+  std::shared_ptr<const OMP::context> m_context =
+      std::make_shared<const OMP::context>();
+  OMP::scratch m_scratch;
 
   Utils::Tags::tagMap m_tags;
-};
 
-inline void merge(bondQueue& _b1, const bondQueue& _b2)
-{
-  _b1.insert(_b1.end(), _b2.begin(), _b2.end());
-}
-
-#pragma omp declare reduction(+ : bondQueue : merge(omp_out, omp_in))
+  // Generations the forces were last evaluated at
+  struct forceState
+  {
+    bool valid = false;
+    bool breaks = false;
+    bool stress = false;
+    std::uint64_t positions = 0;
+    std::uint64_t box = 0;
+    std::uint64_t bonds = 0;
+  };
+  forceState m_forceState;
+  breakKeys m_breakKeys;
+  forceState m_keyState;  // generations the break keys were recorded at
+  std::uint64_t m_boxGen = 0;
+  size_t m_forceEvals = 0;
+  size_t m_avoidedEvals = 0;
+};
 
 }  // namespace networkV4
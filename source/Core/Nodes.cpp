@@ -16,6 +16,7 @@ networkV4::nodes::nodes(const size_t _size)
 
 void networkV4::nodes::clear()
 {
+  m_positionGen++;
   m_globalIndices.clear();
 
   m_positions.clear();
@@ -87,6 +88,7 @@ auto networkV4::nodes::masses() const -> const std::vector<double>&
 
 auto networkV4::nodes::positions() -> std::vector<Utils::Math::vec2d>&
 {
+  m_positionGen++;
   return m_positions;
 }
 
@@ -105,6 +107,11 @@ auto networkV4::nodes::masses() -> std::vector<double>&
   return m_masses;
 }
 
+auto networkV4::nodes::positionGeneration() const -> std::uint64_t
+{
+  return m_positionGen;
+}
+
 auto networkV4::nodes::gatherPositions() const -> std::vector<Utils::Math::vec2d>
 {
   std::vector<Utils::Math::vec2d> positions;
@@ -176,6 +183,7 @@ void networkV4::nodes::pushNode(size_t _globalIndex,
                                 double _mass,
                                 const Utils::Math::vec2d& _force)
 {
+  m_positionGen++;
   m_globalIndices.push_back(_globalIndex);
   m_positions.push_back(_position);
   m_velocities.push_back(_velocity);
@@ -40,11 +40,16 @@ public:
   auto forces() const -> const std::vector<Utils::Math::vec2d>&;
   auto masses() const -> const std::vector<double>&;
 
+  // Advances the position generation, so a reference held across a call to
+  // network::computeForces must be fetched again before writing through it
   auto positions() -> std::vector<Utils::Math::vec2d>&;
   auto velocities() -> std::vector<Utils::Math::vec2d>&;
   auto forces() -> std::vector<Utils::Math::vec2d>&;
   auto masses() -> std::vector<double>&;
 
+  // Changes each time the positions may have been written
+  auto positionGeneration() const -> std::uint64_t;
+
 public:
   auto gatherPositions() const -> std::vector<Utils::Math::vec2d>;
   auto gatherVelocities() const -> std::vector<Utils::Math::vec2d>;
@@ -62,6 +67,7 @@ public:
           "nodes::reorder: order size does not match node size");
     }
 
+    m_positionGen++;
     ranges::sort(ranges::view::zip(_order,
                                    m_globalIndices,
                                    m_positions,
@@ -98,6 +104,8 @@ private:
 
   std::vector<double> m_masses;
 
+  std::uint64_t m_positionGen = 0;
+
   //size_t m_nextIndex = 0;
 };
 }  // namespace networkV4
\ No newline at end of file
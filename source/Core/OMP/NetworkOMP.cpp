@@ -4,6 +4,7 @@
 #include <fstream>
 #include <iostream>
 #include <numeric>
+#include <utility>
 #include <vector>
 
 #include "Core/Network.hpp"
@@ -20,107 +21,242 @@
 
 #if defined(_OPENMP)
 
-networkV4::partition::Partitions networkV4::OMP::threadPartitions;
-size_t networkV4::OMP::passes;
-std::vector<networkV4::stresses> networkV4::OMP::localStresses;
-std::vector<networkV4::bondQueue> networkV4::OMP::localBreaks;
-
 template<bool _evalBreak, bool _evalStress>
 void networkV4::network::computeForces()
 {
+  if (forcesCurrent(_evalBreak, _evalStress)) {
+    m_avoidedEvals++;
+    return;
+  }
+
   m_energy = 0.0;
   m_stresses.zero();
   m_nodes.zeroForce();
+  getClasses();
+  getParams();
+  if constexpr (_evalBreak || _evalStress) {
+    m_breakKeys.begin(m_bonds.size());
+  }
 
-  for (size_t pass = 0; pass < OMP::passes; ++pass) {
-    auto passParts = OMP::threadPartitions | ranges::views::drop(pass)
-        | ranges::views::stride(OMP::passes);
-    computePass<_evalBreak, _evalStress>(passParts);
+  // Keep the context alive for the evaluation even if it is replaced
+  const auto context = m_context;
+  if (context->partitions().empty()) {
+    computePass<_evalBreak, _evalStress>(partition::Partitions {
+        partition::Partition(0, 0, m_nodes.size(), 0, m_bonds.size())});
+  } else {
+    for (size_t pass = 0; pass < context->passes(); ++pass) {
+      auto passParts = context->partitions() | ranges::views::drop(pass)
+          | ranges::views::stride(context->passes());
+      computePass<_evalBreak, _evalStress>(passParts);
+    }
   }
+  recordForces(_evalBreak, _evalStress);
 }
 
 template<bool _evalBreak, bool _evalStress>
 void networkV4::network::computePass(auto _parts)
 {
   const auto& bonds = m_bonds.getBonds();
+  const auto& ids = m_bonds.getIds();
   auto& types = m_bonds.getTypes();
   auto& breaks = m_bonds.getBreaks();
   auto& tags = m_bonds.getTags();
 
-  const auto& positions = m_nodes.positions();
-  auto& forces = m_nodes.forces();
+  const auto& classIds = m_classes.classIds();
+  const bool table = BOND_PARAM_TABLE && m_params.usable();
 
-#  pragma omp parallel for reduction(+ : m_energy) num_threads(_parts.size()) \
-      schedule(static, 1)
-  for (const auto part : _parts) {
-    size_t threadID = omp_get_thread_num();
-    auto& localStresses = OMP::localStresses[threadID];
-    auto& localBreaks = OMP::localBreaks[threadID];
+  const auto& positions = std::as_const(m_nodes).positions();
+  auto& forces = m_nodes.forces();
 
-    if constexpr (_evalStress) {
-      localStresses.zero();
-      localStresses.init(m_stresses.getInitilised());
+  const size_t partCount = _parts.size();
+  if (partCount == 0) {
+    return;
+  }
+  auto& accumulators = m_scratch.accumulators;
+  auto& breakSlots = m_scratch.breakSlots;
+  if (accumulators.size() < partCount) {
+    accumulators.resize(partCount);
+  }
+  if constexpr (_evalBreak || _evalStress) {
+    if (breakSlots.size() < partCount) {
+      breakSlots.resize(partCount);
     }
+  }
 
-    if constexpr (_evalBreak) {
-      localBreaks.clear();
-    }
+  const size_t teamSize = m_context->teamSize(partCount);
 
-    for (size_t i = part.bondStart(); i < part.bondEnd(); i++) {
-      const auto& bond = bonds[i];
-      auto& type = types[i];
-      auto& brk = breaks[i];
-      auto& bTags = tags[i];
-
-      if constexpr (!_evalBreak
-                    && std::is_same_v<Forces::VirtualBond, decltype(type)>)
-      {
-        continue;
+#  pragma omp parallel num_threads(teamSize)
+  {
+    const size_t threads = omp_get_num_threads();
+    const size_t threadID = omp_get_thread_num();
+    auto& local = accumulators[threadID];
+
+    local.stress.fill(Utils::tensor2d());
+    local.energy = 0.0;
+
+    // fewer threads than partitions may be granted, parts of one pass never
+    // share nodes so a thread can take several
+    for (size_t p = threadID; p < partCount; p += threads) {
+      const auto part = _parts[p];
+      if constexpr (_evalBreak || _evalStress) {
+        breakSlots[p].breaks.clear();
+        breakSlots[p].changed.clear();
       }
+      for (size_t i = part.bondStart(); i < part.bondEnd(); i++) {
+        const auto& bond = bonds[i];
+        auto& type = types[i];
+        auto& brk = breaks[i];
+        auto& bTags = tags[i];
 
-      const auto& pos1 = positions[bond.src];
-      const auto& pos2 = positions[bond.dst];
-      const auto dist = m_box.minDist(pos1, pos2);
+        if constexpr (!_evalBreak
+                      && std::is_same_v<Forces::VirtualBond, decltype(type)>)
+        {
+          continue;
+        }
+
+        const auto& pos1 = positions[bond.src];
+        const auto& pos2 = positions[bond.dst];
+        const auto dist = m_box.minDist(pos1, pos2);
+
+        if constexpr (_evalBreak) {
+          const bool broken = table ? m_params.breaks(i, dist)
+                                    : bonded::visitBreak(brk, dist);
+          if (broken) {
+            breakSlots[p].breaks.push_back(breakEvent::from(i,
+                                                            ids[i],
+                                                            bond,
+                                                            type,
+                                                            brk,
+                                                            bTags,
+                                                            m_clockStrain,
+                                                            m_clockTime));
+
+            type = Forces::VirtualBond {};
+            brk = BreakTypes::None {};
+
+            bTags.set(BROKEN_TAG_INDEX);
+            if (recordKeys(i, dist, brk)) {
+              breakSlots[p].changed.push_back(i);
+            }
+
+            // virtual now, the table only learns of the break after the pass
+            continue;
+          }
+        }
+        if constexpr (_evalBreak || _evalStress) {
+          if (recordKeys(i, dist, brk)) {
+            breakSlots[p].changed.push_back(i);
+          }
+        }
 
-      if constexpr (_evalBreak) {
-        const bool broken = bonded::visitBreak(brk, dist);
-        if (broken) {
-          localBreaks.emplace_back(bond, type, brk, bTags);
+        std::optional<Utils::Math::vec2d> force;
+        std::optional<double> energy;
+        if (table) {
+          std::tie(force, energy) = m_params.evaluate(i, dist);
+        } else {
+          force = bonded::visitForce(type, dist);
+          energy = bonded::visitEnergy(type, dist);
+        }
+
+        if (force) {
+          const auto& f = force.value();
+          forces[bond.src] += f;
+          forces[bond.dst] -= f;
 
-          type = Forces::VirtualBond {};
-          brk = BreakTypes::None {};
+          if constexpr (_evalStress) {
+            local.stress[classIds[i]] +=
+                Utils::Math::tensorProduct(f, -dist) * m_box.invArea();
+          }
+        }
 
-          bTags.set(BROKEN_TAG_INDEX);
+        if (energy) {
+          local.energy += energy.value();
         }
       }
+    }
 
-      const auto force = bonded::visitForce(type, dist);
-      if (force) {
-        const auto& f = force.value();
-        forces[bond.src] += f;
-        forces[bond.dst] -= f;
+#  pragma omp barrier
 
+    // Tree reduction of the sums into thread 0, at each level a thread folds
+    // in the one stride above it
+    for (size_t stride = 1; stride < threads; stride *= 2) {
+      if (threadID % (2 * stride) == 0 && threadID + stride < threads) {
+        const auto& other = accumulators[threadID + stride];
+        local.energy += other.energy;
         if constexpr (_evalStress) {
-          const auto stress =
-              Utils::Math::tensorProduct(f, -dist) * m_box.invArea();
-          localStresses.distribute(stress, bTags);
+          for (size_t c = 0; c < local.stress.size(); c++) {
+            local.stress[c] += other.stress[c];
+          }
         }
       }
+#  pragma omp barrier
+    }
+  }
 
-      const auto energy = bonded::visitEnergy(type, dist);
-      if (energy) {
-        m_energy += energy.value();
+  m_energy += accumulators[0].energy;
+  if constexpr (_evalStress) {
+    m_stresses.distribute(accumulators[0].stress);
+  }
+  if constexpr (_evalBreak || _evalStress) {
+    for (size_t p = 0; p < partCount; p++) {
+      for (const auto& event : breakSlots[p].breaks) {
+        recordBreak(event);
+        m_breakQueue.push_back(event);
+      }
+      for (const auto index : breakSlots[p].changed) {
+        m_breakKeys.changed(index);
       }
     }
+  }
+}
 
-    if constexpr (_evalStress) {
-#  pragma omp critical
-      merge(m_stresses, localStresses);
+void networkV4::network::computeHessianProduct(
+    const std::vector<Utils::Math::vec2d>& _v,
+    std::vector<Utils::Math::vec2d>& _Hv) const
+{
+  _Hv.assign(_v.size(), Utils::Math::vec2d({0.0, 0.0}));
+
+  const auto context = m_context;
+  if (context->partitions().empty()) {
+    computeHessianPass(partition::Partitions {partition::Partition(
+                           0, 0, m_nodes.size(), 0, m_bonds.size())},
+                       _v,
+                       _Hv);
+  } else {
+    for (size_t pass = 0; pass < context->passes(); ++pass) {
+      auto passParts = context->partitions() | ranges::views::drop(pass)
+          | ranges::views::stride(context->passes());
+      computeHessianPass(passParts, _v, _Hv);
     }
+  }
+}
 
-    if constexpr (_evalBreak) {
-#  pragma omp critical
-      merge(m_breakQueue, localBreaks);
+void networkV4::network::computeHessianPass(
+    auto _parts,
+    const std::vector<Utils::Math::vec2d>& _v,
+    std::vector<Utils::Math::vec2d>& _Hv) const
+{
+  const auto& bonds = m_bonds.getBonds();
+  const auto& types = m_bonds.getTypes();
+  const auto& positions = m_nodes.positions();
+
+  const size_t teamSize = m_context->teamSize(_parts.size());
+
+#  pragma omp parallel for num_threads(teamSize) schedule(static, 1)
+  for (const auto part : _parts) {
+    for (size_t i = part.bondStart(); i < part.bondEnd(); i++) {
+      const auto& bond = bonds[i];
+
+      const auto& pos1 = positions[bond.src];
+      const auto& pos2 = positions[bond.dst];
+      const auto dist = m_box.minDist(pos1, pos2);
+
+      const auto Hv =
+          bonded::visitHessian(types[i], dist, _v[bond.src] - _v[bond.dst]);
+      if (Hv) {
+        _Hv[bond.src] += Hv.value();
+        _Hv[bond.dst] -= Hv.value();
+      }
     }
   }
 }
@@ -132,11 +268,15 @@ template void networkV4::network::computeForces<false, true>();
 template void networkV4::network::computeForces<true, true>();
 
 template void networkV4::network::computePass<false, false>(
-    decltype(OMP::threadPartitions));
+    partition::Partitions);
 template void networkV4::network::computePass<true, false>(
-    decltype(OMP::threadPartitions));
+    partition::Partitions);
 template void networkV4::network::computePass<false, true>(
-    decltype(OMP::threadPartitions));
+    partition::Partitions);
 template void networkV4::network::computePass<true, true>(
-    decltype(OMP::threadPartitions));
+    partition::Partitions);
+template void networkV4::network::computeHessianPass(
+    partition::Partitions,
+    const std::vector<Utils::Math::vec2d>&,
+    std::vector<Utils::Math::vec2d>&) const;
 #endif
\ No newline at end of file
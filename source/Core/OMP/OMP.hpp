@@ -1,5 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "Core/BreakLog.hpp"
+#include "Core/Stresses.hpp"
 #include "Partition.hpp"
 
 namespace networkV4
@@ -7,10 +13,100 @@ namespace networkV4
 namespace OMP
 {
 
-extern partition::Partitions threadPartitions;
-extern size_t passes;
-extern std::vector<networkV4::stresses> localStresses;
-extern std::vector<networkV4::bondQueue> localBreaks;
+// Sums private to one thread during a force pass, each on its own cache lines
+struct alignas(64) accumulator
+{
+  classStresses stress;
+  double energy = 0.0;
+};
+
+// Breaks and changed break keys found in one partition of a pass. Slots keep
+// their capacity between passes and are joined in partition order, so the
+// break queue does not depend on the team size.
+struct alignas(64) breakSlot
+{
+  std::vector<breakEvent> breaks;
+  std::vector<size_t> changed;
+};
+
+// How a network's force loops run: the partitions, the number of passes they
+// are split into and the team size. It is read only once made, so copies of a
+// network share it and can still be evaluated concurrently.
+class context
+{
+public:
+  context() = default;
+  // _threads of 0 takes the team size of the calling thread
+  context(partition::Partitions _partitions, size_t _passes, size_t _threads)
+      : m_partitions(std::move(_partitions))
+      , m_passes(std::max<size_t>(1, _passes))
+      , m_threads(_threads)
+  {
+  }
+
+public:
+  auto partitions() const -> const partition::Partitions&
+  {
+    return m_partitions;
+  }
+  auto passes() const -> size_t { return m_passes; }
+  auto threads() const -> size_t { return m_threads; }
+
+  // Threads for a pass over _parts partitions
+  auto teamSize(size_t _parts) const -> size_t
+  {
+#if defined(_OPENMP)
+    const size_t threads = m_threads > 0
+        ? m_threads
+        : static_cast<size_t>(omp_get_max_threads());
+    return std::max<size_t>(1, std::min(_parts, threads));
+#else
+    return 1;
+#endif
+  }
+
+private:
+  partition::Partitions m_partitions;
+  size_t m_passes = 1;
+  size_t m_threads = 0;
+};
+
+// Sets the team size of the calling thread's parallel regions while it lives,
+// the previous size is restored even when an exception unwinds past it
+class teamScope
+{
+public:
+  explicit teamScope(size_t _threads)
+  {
+#if defined(_OPENMP)
+    m_previous = omp_get_max_threads();
+    omp_set_num_threads(static_cast<int>(std::max<size_t>(1, _threads)));
+#endif
+  }
+  teamScope(const teamScope&) = delete;
+  auto operator=(const teamScope&) -> teamScope& = delete;
+  ~teamScope()
+  {
+#if defined(_OPENMP)
+    omp_set_num_threads(m_previous);
+#endif
+  }
+
+private:
+  int m_previous = 1;
+};
+
+// Scratch of a network's force passes. Copies start empty, a copied network
+// never shares its sums with the original.
+struct scratch
+{
+  scratch() = default;
+  scratch(const scratch&) {}
+  auto operator=(const scratch&) -> scratch& { return *this; }
+
+  std::vector<accumulator> accumulators;  // per thread
+  std::vector<breakSlot> breakSlots;  // per partition of a pass
+};
 
 } // namespace OMP
-}  // namespace networkV4
\ No newline at end of file
+}  // namespace networkV4
@@ -0,0 +1,371 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Core/BondParams.hpp"
+#include "Core/Network.hpp"
+#include "Core/OMP/OMP.hpp"
+#include "Misc/Config.hpp"
+
+namespace networkV4
+{
+
+// Force passes over replica batches, summed over the batches of a run
+struct replicaThroughput
+{
+  size_t passes = 0;
+  size_t replicaPasses = 0;  // passes times replicas
+  size_t bondEvals = 0;  // bonds times replicas
+  double seconds = 0.0;
+
+  auto operator+=(const replicaThroughput& _other) -> replicaThroughput&
+  {
+    passes += _other.passes;
+    replicaPasses += _other.replicaPasses;
+    bondEvals += _other.bondEvals;
+    seconds += _other.seconds;
+    return *this;
+  }
+
+  void report(std::ostream& _out) const
+  {
+    if (passes == 0 || seconds <= 0.0) {
+      return;
+    }
+    const double replicas = double(replicaPasses) / double(passes);
+    _out << "Replica batches: " << passes << " passes of " << replicas
+         << " replicas, " << bondEvals / seconds / replicas
+         << " bond evaluations/s per replica" << std::endl;
+  }
+};
+
+// R copies of one network that differ in positions and box, and by a few
+// broken bonds. Coordinates are stored [node][dim][replica] so the force loop
+// loads each bond's endpoints and parameters once and evaluates the replicas
+// in SIMD lanes, a broken bond with a lane weight of 0. Only harmonic bonds
+// from a usable parameter table are supported, and breaks are not evaluated:
+// load a network, relax, store it.
+class replicaBatch
+{
+public:
+  replicaBatch() = delete;
+  // The topology is taken from _network, every replica starts as a copy of it
+  replicaBatch(const network& _network, size_t _replicas)
+      : m_replicas(_replicas)
+      , m_nodes(_network.getNodes().size())
+  {
+    if (m_replicas == 0) {
+      throw std::runtime_error("replicaBatch: no replicas");
+    }
+    const auto& params = _network.getParams();
+    if (!params.usable()) {
+      throw std::runtime_error("replicaBatch: bond parameters not tabulated");
+    }
+
+    const auto& bonds = _network.getBonds().getBonds();
+    for (size_t i = 0; i < bonds.size(); i++) {
+      const auto& entry = params.params(i);
+      if (!entry.harmonic) {
+        continue;
+      }
+      const double r0 = params.restLength(i);
+      m_bonds.push_back({bonds[i].src,
+                         bonds[i].dst,
+                         entry.normalized ? entry.k / r0 : entry.k,
+                         r0});
+      m_bondIndex.push_back(i);
+    }
+    m_masses = _network.getNodes().masses();
+    setContext(_network.getContext());
+
+    const size_t lanes = 2 * m_nodes * m_replicas;
+    m_positions.assign(lanes, 0.0);
+    m_velocities.assign(lanes, 0.0);
+    m_forces.assign(lanes, 0.0);
+    m_Lx.resize(m_replicas);
+    m_Ly.resize(m_replicas);
+    m_xy.resize(m_replicas);
+    m_energy.assign(m_replicas, 0.0);
+    m_weights.assign(m_bonds.size() * m_replicas, 1.0);
+    for (size_t r = 0; r < m_replicas; r++) {
+      load(r, _network);
+    }
+  }
+
+public:
+  auto replicas() const -> size_t { return m_replicas; }
+  auto nodes() const -> size_t { return m_nodes; }
+
+  // Copies the positions and box of _network into replica _r. Its bonds must
+  // be those of the batch, some of them broken.
+  void load(size_t _r, const network& _network)
+  {
+    const auto& params = _network.getParams();
+    if (_network.getNodes().size() != m_nodes) {
+      throw std::runtime_error("replicaBatch::load: node count differs");
+    }
+    if (params.size() != _network.getBonds().size()) {
+      throw std::runtime_error("replicaBatch::load: stale parameter table");
+    }
+
+    size_t cut = 0;
+    size_t harmonic = 0;
+    for (size_t i = 0; i < params.size(); i++) {
+      harmonic += params.params(i).harmonic ? 1 : 0;
+    }
+    const auto& bonds = _network.getBonds().getBonds();
+    for (size_t b = 0; b < m_bonds.size(); b++) {
+      const size_t i = m_bondIndex[b];
+      if (bonds[i].src != m_bonds[b].src || bonds[i].dst != m_bonds[b].dst) {
+        throw std::runtime_error("replicaBatch::load: topology differs");
+      }
+      const bool live = params.params(i).harmonic;
+      m_weights[b * m_replicas + _r] = live ? 1.0 : 0.0;
+      cut += live ? 0 : 1;
+    }
+    if (harmonic + cut != m_bonds.size()) {
+      throw std::runtime_error("replicaBatch::load: bond missing from batch");
+    }
+
+    const auto& positions = _network.getNodes().positions();
+    for (size_t n = 0; n < m_nodes; n++) {
+      x(n, _r) = positions[n][0];
+      y(n, _r) = positions[n][1];
+    }
+    const auto& box = _network.getBox();
+    m_Lx[_r] = box.getLx();
+    m_Ly[_r] = box.getLy();
+    m_xy[_r] = box.getxy();
+  }
+
+  // Copies the positions of replica _r back into _network
+  void store(size_t _r, network& _network) const
+  {
+    auto& positions = _network.getNodes().positions();
+    for (size_t n = 0; n < m_nodes; n++) {
+      positions[n] = {x(n, _r), y(n, _r)};
+    }
+  }
+
+public:
+  // Forces and energies of every replica. The bonds run over the network's
+  // partitions, pass by pass, and the energies are summed in partition order
+  // so they do not depend on the team size.
+  void computeForces()
+  {
+    const auto start = std::chrono::steady_clock::now();
+    const size_t R = m_replicas;
+    std::fill(m_forces.begin(), m_forces.end(), 0.0);
+    std::fill(m_energy.begin(), m_energy.end(), 0.0);
+
+    size_t tooShort = 0;
+    for (const auto& pass : m_passes) {
+      const size_t teamSize = m_context.teamSize(pass.size());
+#pragma omp parallel for num_threads(teamSize) schedule(static, 1) \
+    reduction(+ : tooShort)
+      for (size_t p = 0; p < pass.size(); p++) {
+        tooShort += computePart(m_context.partitions()[pass[p]],
+                                &m_partEnergy[pass[p] * R]);
+      }
+    }
+    if (tooShort > 0) {
+      throw("replicaBatch::computeForces: r is too small");
+    }
+    for (size_t p = 0; p < m_context.partitions().size(); p++) {
+      for (size_t r = 0; r < R; r++) {
+        m_energy[r] += m_partEnergy[p * R + r];
+      }
+    }
+
+    m_throughput.passes++;
+    m_throughput.replicaPasses += R;
+    m_throughput.bondEvals += m_bonds.size() * R;
+    m_throughput.seconds += std::chrono::duration<double>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+  }
+
+  auto energy(size_t _r) const -> double { return m_energy[_r]; }
+  auto throughput() const -> const replicaThroughput& { return m_throughput; }
+
+  // Flat arrays, entry index(node, dim, replica)
+  auto positions() -> std::vector<double>& { return m_positions; }
+  auto velocities() -> std::vector<double>& { return m_velocities; }
+  auto forces() const -> const std::vector<double>& { return m_forces; }
+  auto masses() const -> const std::vector<double>& { return m_masses; }
+
+  auto index(size_t _node, size_t _dim, size_t _r) const -> size_t
+  {
+    return (2 * _node + _dim) * m_replicas + _r;
+  }
+
+private:
+  struct bond
+  {
+    bonded::nodeIndex src;
+    bonded::nodeIndex dst;
+    double k;  // normalised already
+    double r0;
+  };
+
+  struct bondForce
+  {
+    double fx;  // on the source
+    double fy;
+    double energy;
+    bool tooShort;  // r below ROUND_ERROR_PRECISION in a live lane
+  };
+
+  // Bonds of _part in every replica, their energies written to _energy.
+  // Returns the number of live lanes too short to evaluate.
+  auto computePart(const partition::Partition& _part, double* _energy)
+      -> size_t
+  {
+    const size_t R = m_replicas;
+    const double* Lx = m_Lx.data();
+    const double* Ly = m_Ly.data();
+    const double* xy = m_xy.data();
+    std::fill(_energy, _energy + R, 0.0);
+
+    size_t tooShort = 0;
+    for (size_t b = _part.bondStart(); b < _part.bondEnd(); b++) {
+      const auto& bond = m_bonds[b];
+      const double* weight = &m_weights[b * R];
+      const double* srcX = &m_positions[2 * R * bond.src];
+      const double* dstX = &m_positions[2 * R * bond.dst];
+      double* srcF = &m_forces[2 * R * bond.src];
+      double* dstF = &m_forces[2 * R * bond.dst];
+      const double k = bond.k;
+      const double r0 = bond.r0;
+
+#pragma omp simd reduction(+ : tooShort)
+      for (size_t r = 0; r < R; r++) {
+        const auto [fx, fy, e, bad] = evaluate(srcX[r] - dstX[r],
+                                               srcX[R + r] - dstX[R + r],
+                                               k,
+                                               r0,
+                                               Lx[r],
+                                               Ly[r],
+                                               xy[r],
+                                               weight[r]);
+        srcF[r] += fx;
+        srcF[R + r] += fy;
+        dstF[r] -= fx;
+        dstF[R + r] -= fy;
+        _energy[r] += e;
+        tooShort += bad ? 1 : 0;
+      }
+    }
+    return tooShort;
+  }
+
+  // Harmonic bond, minimum image as box::minDist, scaled by the lane
+  // weight _w. A live lane shorter than ROUND_ERROR_PRECISION is flagged, as
+  // HarmonicBond::force throws there, and gives no force.
+  static auto evaluate(double _dx,
+                       double _dy,
+                       double _k,
+                       double _r0,
+                       double _Lx,
+                       double _Ly,
+                       double _xy,
+                       double _w) -> bondForce
+  {
+    const double ny = std::floor(_dy / _Ly + 0.5);
+    _dy -= ny * _Ly;
+    _dx -= ny * _xy;
+    _dx -= std::floor(_dx / _Lx + 0.5) * _Lx;
+    const double r = std::sqrt(_dx * _dx + _dy * _dy);
+    const double dr = r - _r0;
+    const bool valid = r > ROUND_ERROR_PRECISION;
+    const double fac = valid ? -_w * _k * dr / r : 0.0;
+    return {
+        fac * _dx, fac * _dy, 0.5 * _w * _k * dr * dr, !valid && _w > 0.0};
+  }
+
+  // Maps the partitions of _context onto the harmonic bonds. m_bondIndex is
+  // sorted, so every partition keeps a contiguous range. Without partitions
+  // all bonds are one partition.
+  void setContext(const OMP::context& _context)
+  {
+    auto rank = [&](size_t _i) -> size_t
+    {
+      return std::lower_bound(m_bondIndex.begin(), m_bondIndex.end(), _i)
+          - m_bondIndex.begin();
+    };
+    partition::Partitions partitions;
+    for (const auto& part : _context.partitions()) {
+      partitions.emplace_back(part.index(),
+                              part.nodeStart(),
+                              part.nodeEnd(),
+                              rank(part.bondStart()),
+                              rank(part.bondEnd()));
+    }
+    size_t passes = _context.passes();
+    if (partitions.empty()) {
+      partitions.emplace_back(0, 0, m_nodes, 0, m_bonds.size());
+      passes = 1;
+    }
+
+    m_passes.assign(passes, {});
+    for (size_t p = 0; p < partitions.size(); p++) {
+      m_passes[p % passes].push_back(p);
+    }
+    m_partEnergy.assign(partitions.size() * m_replicas, 0.0);
+    m_context =
+        OMP::context(std::move(partitions), passes, _context.threads());
+  }
+
+  auto x(size_t _node, size_t _r) -> double&
+  {
+    return m_positions[index(_node, 0, _r)];
+  }
+  auto y(size_t _node, size_t _r) -> double&
+  {
+    return m_positions[index(_node, 1, _r)];
+  }
+  auto x(size_t _node, size_t _r) const -> double
+  {
+    return m_positions[index(_node, 0, _r)];
+  }
+  auto y(size_t _node, size_t _r) const -> double
+  {
+    return m_positions[index(_node, 1, _r)];
+  }
+
+private:
+  size_t m_replicas;
+  size_t m_nodes;
+
+  std::vector<bond> m_bonds;  // the harmonic bonds of the topology
+  std::vector<size_t> m_bondIndex;  // their index in the network
+  // [bond][replica], 0 where the replica's bond is broken so it drops out
+  // of the SIMD loop without a branch
+  std::vector<double> m_weights;
+  std::vector<double> m_masses;
+
+  std::vector<double> m_positions;
+  std::vector<double> m_velocities;
+  std::vector<double> m_forces;
+  std::vector<double> m_Lx;
+  std::vector<double> m_Ly;
+  std::vector<double> m_xy;
+  std::vector<double> m_energy;
+
+  // The network's partitions with bond ranges into m_bonds, and the
+  // partitions of each pass
+  OMP::context m_context;
+  std::vector<std::vector<size_t>> m_passes;
+  std::vector<double> m_partEnergy;  // [partition][replica]
+
+  replicaThroughput m_throughput;
+};
+
+}  // namespace networkV4
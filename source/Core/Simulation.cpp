@@ -1,3 +1,8 @@
+#include <atomic>
+#include <iostream>
+#include <map>
+#include <thread>
+
 #include "Simulation.hpp"
 
 // #include "Misc/EnumString.hpp"
@@ -21,6 +26,7 @@ void networkV4::tomlLoad::readNeworkIN()
   }
   std::filesystem::path networkPath =
       toml::find<std::string>(m_config, "LoadPath");
+  m_networkPath = networkPath;
 
   const std::string version =
       toml::find_or<std::string>(m_config, "Version", "BinV2");
@@ -67,7 +73,8 @@ void networkV4::tomlLoad::readOutputConfig()
   }
 }
 
-auto networkV4::tomlLoad::loadtimeSeries(const std::string& _name)
+auto networkV4::tomlLoad::loadtimeSeries(const std::string& _name,
+                                         const std::filesystem::path& _dir)
     -> std::shared_ptr<IO::timeSeries::timeSeriesOut>
 {
   auto outConfig = toml::find(m_config, "Output");
@@ -75,7 +82,7 @@ auto networkV4::tomlLoad::loadtimeSeries(const std::string& _name)
       toml::find_or<std::string>(outConfig, "OutputType", "CSV");
 
   if (outString == "CSV") {
-    const std::filesystem::path path = m_timeSeriesPath / (_name + ".csv");
+    const std::filesystem::path path = _dir / (_name + ".csv");
     return std::make_shared<IO::timeSeries::CSVOut>(path);
   } else {
     throw std::runtime_error("OutputType not implemented");
@@ -83,6 +90,7 @@ auto networkV4::tomlLoad::loadtimeSeries(const std::string& _name)
 }
 
 auto networkV4::tomlLoad::loadNetworkOut(const std::string& _name,
+                                         const std::filesystem::path& _dir,
                                          const network& _network)
     -> std::shared_ptr<IO::networkDumps::networkDump>
 {
@@ -93,13 +101,13 @@ auto networkV4::tomlLoad::loadNetworkOut(const std::string& _name,
   if (outString == "HDF5") {
     const std::string author =
         toml::find_or<std::string>(outConfig, "Author", "Unknown");
-    const std::filesystem::path path = m_networkDumpPath / (_name + ".h5");
+    const std::filesystem::path path = _dir / (_name + ".h5");
     return std::make_shared<IO::networkDumps::networkOutHDF5>(
         path, _network, author);
 
   } else if (outString == "BinV2") {
     const auto [compType, level] = loadCompression();
-    const std::filesystem::path path = m_networkDumpPath / (_name + ".v2.bin");
+    const std::filesystem::path path = _dir / (_name + ".v2.bin");
     return std::make_shared<IO::networkDumps::networkOutBinV2>(
         path, compType, level);
 
@@ -108,6 +116,79 @@ auto networkV4::tomlLoad::loadNetworkOut(const std::string& _name,
   }
 }
 
+void networkV4::tomlLoad::loadCache(protocols::protocolBase& _protocol) const
+{
+  if (m_config.contains("CachePath")) {
+    loadCache(_protocol,
+              m_config,
+              IO::NetworkIn::relaxedCache::hashFile(m_networkPath));
+  }
+}
+
+void networkV4::tomlLoad::loadCache(protocols::protocolBase& _protocol,
+                                    const toml::value& _config,
+                                    std::uint64_t _inputHash) const
+{
+  if (m_config.contains("CachePath")) {
+    // The overrides change the network the cached states were relaxed from
+    if (_config.contains("Network")) {
+      _inputHash = Utils::Hash::combine(
+          _inputHash,
+          std::hash<std::string> {}(
+              toml::format(toml::find(_config, "Network"))));
+    }
+    auto cache = std::make_shared<IO::NetworkIn::relaxedCache>(
+        toml::find<std::string>(m_config, "CachePath"));
+    _protocol.setInitialCache(cache, _inputHash);
+  }
+}
+
+void networkV4::tomlLoad::applyNetworkConfig(const toml::value& _config,
+                                             network& _network)
+{
+  if (!_config.contains("Network")) {
+    return;
+  }
+  const auto networkConfig = toml::find(_config, "Network");
+  if (!networkConfig.contains("Lambda")) {
+    return;
+  }
+
+  // Tags to match and the lambda they take, later entries win
+  std::vector<std::pair<Utils::Tags::tagFlags, double>> lambdas;
+  const auto& lambda = toml::find(networkConfig, "Lambda");
+  if (lambda.is_table()) {
+    for (const auto& [name, value] : lambda.as_table()) {
+      if (!_network.getTags().has(name)) {
+        throw std::runtime_error("Network.Lambda: no bonds are tagged "
+                                 + name);
+      }
+      lambdas.emplace_back(_network.getTags().get(name),
+                           toml::get<double>(value));
+    }
+  } else {
+    lambdas.emplace_back(Utils::Tags::tagFlags().set(),
+                         toml::get<double>(lambda));
+  }
+
+  auto& bonds = _network.getBonds();
+  const auto& tags = std::as_const(bonds).getTags();
+  auto& breaks = bonds.getBreaks();
+  for (size_t i = 0; i < breaks.size(); i++) {
+    const auto* strain = std::get_if<BreakTypes::StrainBreak>(&breaks[i]);
+    if (strain == nullptr) {
+      continue;
+    }
+    for (const auto& [flags, value] : lambdas) {
+      if (Utils::Tags::hasTagAny(tags[i], flags)) {
+        breaks[i] = BreakTypes::StrainBreak(value, strain->r0());
+        strain = std::get_if<BreakTypes::StrainBreak>(&breaks[i]);
+      }
+    }
+  }
+  bonds.invalidate();
+}
+
 void networkV4::tomlLoad::checkload(const std::filesystem::path& _path)
 {
   if (!std::filesystem::exists(_path)) {
@@ -156,13 +237,15 @@ networkV4::Simulation::Simulation(const std::filesystem::path& _path)
 {
   m_config = toml::parse(_path);
   // loadTypes();
-  initNetwork();
+  applyNetworkConfig(m_config, m_network);
+  initNetwork(m_network);
 
-  m_dataOut = loadtimeSeries("Data");
-  m_bondsOut = loadtimeSeries("Breaks");
-  m_networkOut = loadNetworkOut("NetworkDump", m_network);
+  m_dataOut = loadtimeSeries("Data", m_timeSeriesPath);
+  m_bondsOut = loadtimeSeries("Breaks", m_timeSeriesPath);
+  m_networkOut = loadNetworkOut("NetworkDump", m_networkDumpPath, m_network);
   m_protocol = m_protocolReader->read(
       m_config, m_network, m_dataOut, m_bondsOut, m_networkOut);
+  loadCache(*m_protocol);
 }
 
 networkV4::Simulation::~Simulation() {}
@@ -172,11 +255,11 @@ void networkV4::Simulation::run()
   m_protocol->run(m_network);
 }
 
-void networkV4::Simulation::initNetwork()
+void networkV4::initNetwork(network& _network)
 {
-  auto& nodes = m_network.getNodes();
-  auto& bonds = m_network.getBonds();
-  const auto& box = m_network.getBox();
+  auto& nodes = _network.getNodes();
+  auto& bonds = _network.getBonds();
+  const auto& box = _network.getBox();
 
   partition::PartitionGenerator partGen;
   partGen.assignNodes(nodes.positions(), box);
@@ -184,17 +267,195 @@ void networkV4::Simulation::initNetwork()
   partGen.sortBonds(bonds, nodes);
   partGen.checkPasses(bonds);
 
-  auto test = bonds.gatherBonds();
+#if defined(_OPENMP)
+  _network.setContext(std::make_shared<const OMP::context>(
+      partGen.generatePartitions(nodes, bonds), partGen.getPasses(), 0));
+#endif
+
+  _network.computeForces<false, true>();
+}
+
+//----------------------------------------------------------------------------
+
+networkV4::Sweep::Sweep(const std::filesystem::path& _path)
+    : tomlLoad(_path)
+    , m_network(m_networkIn->load())
+{
+  const auto outConfig = toml::find(m_config, "Output");
+  if (toml::find_or<std::string>(outConfig, "NetworkType", "None") == "HDF5") {
+    throw std::runtime_error("Sweeps cannot write HDF5 network dumps");
+  }
+
+  applyNetworkConfig(m_config, m_network);
+  initNetwork(m_network);
+  readGrid();
+  if (m_config.contains("CachePath")) {
+    m_inputHash = IO::NetworkIn::relaxedCache::hashFile(m_networkPath);
+  }
+
+  const auto& context = m_network.getContext();
+  m_jobContext = std::make_shared<const OMP::context>(
+      context.partitions(), context.passes(), m_threads);
+}
+
+auto networkV4::Sweep::isSweep(const std::filesystem::path& _path) -> bool
+{
+  return std::filesystem::exists(_path)
+      && toml::parse(_path).contains("Sweep");
+}
+
+auto networkV4::Sweep::run() -> size_t
+{
+  for (const auto& job : m_jobs) {
+    std::cout << job.name << ": " << job.label << std::endl;
+  }
 
+  std::atomic<size_t> next = 0;
+  std::atomic<size_t> failed = 0;
+  auto worker = [&]()
+  {
 #if defined(_OPENMP)
-  size_t threadCount = omp_get_max_threads();
-  OMP::threadPartitions = partGen.generatePartitions(nodes, bonds);
-  OMP::passes = partGen.getPasses();
-  OMP::localStresses.resize(threadCount);
-  OMP::localBreaks.resize(threadCount);
+    omp_set_num_threads(static_cast<int>(m_threads));
 #endif
+    for (size_t j = next++; j < m_jobs.size(); j = next++) {
+      try {
+        runJob(m_jobs[j]);
+      } catch (const std::exception& _error) {
+        failed++;
+        std::lock_guard<std::mutex> lock(m_setupMutex);
+        std::cerr << m_jobs[j].name << " failed: " << _error.what()
+                  << std::endl;
+      } catch (const char* _error) {
+        failed++;
+        std::lock_guard<std::mutex> lock(m_setupMutex);
+        std::cerr << m_jobs[j].name << " failed: " << _error << std::endl;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (size_t w = 0; w < std::min(m_workers, m_jobs.size()); w++) {
+    workers.emplace_back(worker);
+  }
+  for (auto& thread : workers) {
+    thread.join();
+  }
+  return failed;
+}
+
+void networkV4::Sweep::readGrid()
+{
+  const auto sweepConfig = toml::find(m_config, "Sweep");
+  m_threads =
+      std::max<size_t>(1, toml::find_or<size_t>(sweepConfig, "Threads", 1));
+  const size_t cores = std::max<size_t>(1, std::thread::hardware_concurrency());
+  m_workers = std::max<size_t>(
+      1,
+      toml::find_or<size_t>(
+          sweepConfig, "Workers", std::max<size_t>(1, cores / m_threads)));
+
+  if (!sweepConfig.contains("Grid")) {
+    throw std::runtime_error("No Grid found in Sweep");
+  }
+
+  // Sorted so the job numbering does not depend on the table order
+  std::map<std::string, toml::array> axes;
+  for (const auto& [key, values] : toml::find(sweepConfig, "Grid").as_table())
+  {
+    if (!values.is_array() || values.as_array().empty()) {
+      throw std::runtime_error("Sweep grid " + key + " is not a list");
+    }
+    checkKey(key);
+    axes.emplace(key, values.as_array());
+  }
 
-  m_network.computeForces<false, true>();
+  size_t count = 1;
+  for (const auto& [key, values] : axes) {
+    count *= values.size();
+  }
+
+  // The last key varies fastest
+  for (size_t j = 0; j < count; j++) {
+    job next {"Job" + std::to_string(j), "", m_config};
+    next.config.as_table().erase("Sweep");
+
+    size_t rest = j;
+    for (auto it = axes.rbegin(); it != axes.rend(); ++it) {
+      const auto& [key, values] = *it;
+      const auto& value = values[rest % values.size()];
+      rest /= values.size();
+
+      setKey(next.config, key, value);
+      next.label = key + " = " + toml::format(value)
+          + (next.label.empty() ? "" : ", ") + next.label;
+    }
+    m_jobs.push_back(std::move(next));
+  }
+}
+
+void networkV4::Sweep::checkKey(const std::string& _key) const
+{
+  const std::string table = _key.substr(0, _key.find('.'));
+  if (table == "Output" || table == "LoadPath" || table == "Version"
+      || table == "CachePath" || table == "Sweep")
+  {
+    throw std::runtime_error("Sweep grid " + _key
+                             + " can only be set in the base config");
+  }
+  // The protocol is chosen from the base config, as in readProtocol
+  const std::string protocol = m_config.contains("QuasiStaticStrain")
+      ? "QuasiStaticStrain"
+      : "Propogator";
+  if ((table == "QuasiStaticStrain" || table == "Propogator")
+      && table != protocol)
+  {
+    throw std::runtime_error("Sweep grid " + _key + " sets up " + table
+                             + ", which the base config does not run");
+  }
+}
+
+void networkV4::Sweep::runJob(const job& _job)
+{
+  network jobNetwork = m_network;
+  jobNetwork.setContext(m_jobContext);
+  applyNetworkConfig(_job.config, jobNetwork);
+  std::shared_ptr<protocols::protocolBase> protocol;
+  {
+    std::lock_guard<std::mutex> lock(m_setupMutex);
+    const auto timeSeriesDir = m_timeSeriesPath / _job.name;
+    const auto networkDumpDir = m_networkDumpPath / _job.name;
+    std::filesystem::create_directories(timeSeriesDir);
+    std::filesystem::create_directories(networkDumpDir);
+
+    auto dataOut = loadtimeSeries("Data", timeSeriesDir);
+    auto bondsOut = loadtimeSeries("Breaks", timeSeriesDir);
+    auto networkOut =
+        loadNetworkOut("NetworkDump", networkDumpDir, jobNetwork);
+    protocol = m_protocolReader->read(
+        _job.config, jobNetwork, dataOut, bondsOut, networkOut);
+    loadCache(*protocol, _job.config, m_inputHash);
+  }
+  protocol->run(jobNetwork);
+}
+
+void networkV4::Sweep::setKey(toml::value& _config,
+                              const std::string& _key,
+                              const toml::value& _value)
+{
+  toml::value* table = &_config;
+  size_t start = 0;
+  for (size_t dot = _key.find('.'); dot != std::string::npos;
+       dot = _key.find('.', start))
+  {
+    auto& entries = table->as_table();
+    const std::string name = _key.substr(start, dot - start);
+    if (entries.count(name) == 0) {
+      entries[name] = toml::table {};
+    }
+    table = &entries[name];
+    start = dot + 1;
+  }
+  table->as_table()[_key.substr(start)] = _value;
 }
 
 /*
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include <toml.hpp>
 
@@ -36,16 +40,37 @@ private:
 
 protected:
   void readOutputConfig();
-  auto loadtimeSeries(const std::string& _name)
+  auto loadtimeSeries(const std::string& _name,
+                      const std::filesystem::path& _dir)
       -> std::shared_ptr<IO::timeSeries::timeSeriesOut>;
-  auto loadNetworkOut(const std::string& _name, const network& _network)
+  auto loadNetworkOut(const std::string& _name,
+                      const std::filesystem::path& _dir,
+                      const network& _network)
       -> std::shared_ptr<IO::networkDumps::networkDump>;
 
+  // Gives _protocol the relaxed state cache named by CachePath, if any
+  void loadCache(protocols::protocolBase& _protocol) const;
+  // As above, with the hash of the input file already known and the network
+  // overrides taken from _config
+  void loadCache(protocols::protocolBase& _protocol,
+                 const toml::value& _config,
+                 std::uint64_t _inputHash) const;
+
+  // Applies the [Network] table of _config to the bonds read from LoadPath.
+  // Lambda sets the break strain of every strain break bond, or, given as a
+  // table of tag names, of the bonds with each tag:
+  //
+  //   [Network]
+  //   Lambda = {sacrificial = 0.1, matrix = 1.5}
+  static void applyNetworkConfig(const toml::value& _config,
+                                 network& _network);
+
 protected:
   toml::value m_config;
 
   std::unique_ptr<IO::NetworkIn::networkIn> m_networkIn;
   std::unique_ptr<protocols::protocolReader> m_protocolReader;
+  std::filesystem::path m_networkPath;
   std::filesystem::path m_timeSeriesPath;
   std::filesystem::path m_networkDumpPath;
 
@@ -67,7 +92,6 @@ public:
 private:
   // void loadTypes();
 
-  void initNetwork();
   // void readDataOut();
   // void readNetworkOut();
   // void readRandom();
@@ -91,4 +115,61 @@ private:
   std::shared_ptr<IO::timeSeries::timeSeriesOut> m_bondsOut;
   std::shared_ptr<IO::networkDumps::networkDump> m_networkOut;
 };
+
+// Partitions _network for the force loops and evaluates its forces
+void initNetwork(network& _network);
+
+// Runs one protocol for every point of the parameter grid in the [Sweep]
+// table. The network is loaded and partitioned once, then the jobs run
+// concurrently, each on its own copy of the network with its own OpenMP team
+// and output directory. The copies share one execution context. The input,
+// outputs, cache and protocol come from the base config, so the grid may not
+// set them. Bond parameters can be swept through the [Network] table, e.g.
+// "Network.Lambda.sacrificial" = [0.1, 0.2], see applyNetworkConfig.
+//
+//   [Sweep]
+//   Threads = 4  # per job, default 1
+//   Workers = 16  # jobs at once, default cores / Threads
+//   [Sweep.Grid]
+//   "Propogator.MaxStep" = [1e-2, 5e-3]
+//   "Minimiser.Type" = ["FIRE2", "CG"]
+class Sweep : public tomlLoad
+{
+public:
+  Sweep(const std::filesystem::path& _path);
+  ~Sweep() = default;
+
+public:
+  static auto isSweep(const std::filesystem::path& _path) -> bool;
+
+  // Runs every job, returns the number that failed
+  auto run() -> size_t;
+
+private:
+  struct job
+  {
+    std::string name;  // output subdirectory
+    std::string label;  // the grid values
+    toml::value config;
+  };
+
+  void readGrid();
+  // Throws if _key is one only the base config may set
+  void checkKey(const std::string& _key) const;
+  void runJob(const job& _job);
+
+  // Sets the dotted _key, e.g. "Propogator.MaxStep", making missing tables
+  static void setKey(toml::value& _config,
+                     const std::string& _key,
+                     const toml::value& _value);
+
+private:
+  networkV4::network m_network;
+  std::shared_ptr<const OMP::context> m_jobContext;
+  std::uint64_t m_inputHash = 0;  // of LoadPath, hashed once for every job
+  std::vector<job> m_jobs;
+  size_t m_threads = 1;
+  size_t m_workers = 1;
+  std::mutex m_setupMutex;  // readers and output files are made one at a time
+};
 }  // namespace networkV4
\ No newline at end of file
@@ -1,13 +1,19 @@
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <cstdint>
 #include <vector>
 
+#include "Misc/Config.hpp"
 #include "Misc/Math/Tensor2.hpp"
 
 namespace networkV4
 {
 
+// Stress sums per tag class, entry c for the bonds whose tag bits are c
+using classStresses = std::array<Utils::tensor2d, (size_t(1) << NUM_TAGS)>;
+
 class stresses
 {
 public:
@@ -89,6 +95,15 @@ public:
     }
   }
 
+  // Adds sums accumulated per tag class, so the tag bits are only visited
+  // once per class rather than once per bond
+  void distribute(const classStresses& _classes)
+  {
+    for (size_t c = 0; c < _classes.size(); ++c) {
+      distribute(_classes[c], std::bitset<NUM_TAGS>(c));
+    }
+  }
+
 private:
   void init(size_t _index, const Utils::tensor2d& _value)
   {
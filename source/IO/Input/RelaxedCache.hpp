@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Core/Network.hpp"
+#include "IO/BaseIO.hpp"
+#include "Misc/Hash.hpp"
+
+namespace IO
+{
+namespace NetworkIn
+{
+
+// On-disk cache of relaxed node positions, one file per key. A file is a
+// fixed header followed by the raw positions, so loading maps the file and
+// copies the positions straight into the network without parsing. Files are
+// written to a temporary name unique to the process and thread, then renamed,
+// so concurrent runs and sweep jobs sharing the folder never see a partial
+// file.
+class relaxedCache : public folderIO
+{
+public:
+  relaxedCache(const std::filesystem::path& _dirPath)
+      : folderIO(_dirPath)
+  {
+  }
+  ~relaxedCache() override = default;
+
+public:
+  // Loads the positions stored under _key, false if there are none or they do
+  // not match the network's node count and box
+  auto load(std::uint64_t _key, networkV4::network& _network) const -> bool
+  {
+    const auto path = filePath(_key);
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0
+        || static_cast<size_t>(info.st_size) < sizeof(header))
+    {
+      ::close(fd);
+      return false;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return false;
+    }
+
+    const auto* head = static_cast<const header*>(data);
+    auto& positions = _network.getNodes().positions();
+    const auto& box = _network.getBox();
+    const bool valid = head->magic == MAGIC && head->version == VERSION
+        && head->key == _key && head->nodes == positions.size()
+        && size == sizeof(header) + head->nodes * sizeof(Utils::Math::vec2d)
+        && head->Lx == box.getLx() && head->Ly == box.getLy()
+        && head->xy == box.getxy();
+    if (valid) {
+      std::memcpy(positions.data(),
+                  static_cast<const char*>(data) + sizeof(header),
+                  head->nodes * sizeof(Utils::Math::vec2d));
+    }
+    ::munmap(data, size);
+    return valid;
+  }
+
+  void save(std::uint64_t _key, const networkV4::network& _network) const
+  {
+    const auto& positions = _network.getNodes().positions();
+    const auto& box = _network.getBox();
+    const header head {MAGIC,
+                       VERSION,
+                       _key,
+                       positions.size(),
+                       box.getLx(),
+                       box.getLy(),
+                       box.getxy()};
+
+    const auto path = filePath(_key);
+    auto tmpPath = path;
+    tmpPath += ".tmp" + std::to_string(::getpid()) + "."
+        + std::to_string(std::hash<std::thread::id> {}(
+            std::this_thread::get_id()));
+    {
+      std::ofstream file(tmpPath, std::ios::out | std::ios::binary);
+      if (!file) {
+        throw std::runtime_error("File " + tmpPath.string()
+                                 + " cannot be created.");
+      }
+      file.write(reinterpret_cast<const char*>(&head), sizeof(header));
+      file.write(reinterpret_cast<const char*>(positions.data()),
+                 positions.size() * sizeof(Utils::Math::vec2d));
+    }
+    std::filesystem::rename(tmpPath, path);
+  }
+
+  // Hash of the contents of _path
+  static auto hashFile(const std::filesystem::path& _path) -> std::uint64_t
+  {
+    std::ifstream file(_path, std::ios::in | std::ios::binary);
+    if (!file) {
+      throw std::runtime_error("File " + _path.string()
+                               + " cannot be opened.");
+    }
+    std::uint64_t hash = 0;
+    std::vector<std::uint64_t> buffer(1 << 16);
+    while (file) {
+      file.read(reinterpret_cast<char*>(buffer.data()),
+                buffer.size() * sizeof(std::uint64_t));
+      const auto bytes = static_cast<size_t>(file.gcount());
+      const size_t words = (bytes + sizeof(std::uint64_t) - 1)
+          / sizeof(std::uint64_t);
+      // zero the tail of a partial last word
+      std::memset(reinterpret_cast<char*>(buffer.data()) + bytes,
+                  0,
+                  words * sizeof(std::uint64_t) - bytes);
+      for (size_t i = 0; i < words; i++) {
+        hash = Utils::Hash::combine(hash, buffer[i]);
+      }
+      hash = Utils::Hash::combine(hash, bytes);
+    }
+    return hash;
+  }
+
+  // Hash of the node positions, in memory order
+  static auto hashPositions(const networkV4::network& _network)
+      -> std::uint64_t
+  {
+    std::uint64_t hash = 0;
+    for (const auto& pos : _network.getNodes().positions()) {
+      hash = Utils::Hash::combine(hash, std::bit_cast<std::uint64_t>(pos[0]));
+      hash = Utils::Hash::combine(hash, std::bit_cast<std::uint64_t>(pos[1]));
+    }
+    return hash;
+  }
+
+private:
+  static constexpr std::array<char, 8> MAGIC = {
+      'N', 'V', '4', 'R', 'L', 'X', '\0', '\0'};
+  static constexpr std::uint64_t VERSION = 1;
+
+  struct header
+  {
+    std::array<char, 8> magic;
+    std::uint64_t version;
+    std::uint64_t key;
+    std::uint64_t nodes;
+    double Lx;
+    double Ly;
+    double xy;
+  };
+
+  auto filePath(std::uint64_t _key) const -> std::filesystem::path
+  {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << _key
+         << ".relaxed.bin";
+    return m_dirPath / name.str();
+  }
+};
+
+}  // namespace NetworkIn
+}  // namespace IO
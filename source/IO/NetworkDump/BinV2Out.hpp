@@ -80,8 +80,8 @@ public:
         throw("networkOutBinV2: harmonic bond must be normalized");
       }
 
-      append(ss, info.src);
-      append(ss, info.dst);
+      append(ss, static_cast<size_t>(info.src));
+      append(ss, static_cast<size_t>(info.dst));
       bool connected =
           std::holds_alternative<networkV4::Forces::HarmonicBond>(type);
       append(ss, connected);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <utility>
 #include <vector>
 
 #include <range/v3/view/zip.hpp>
@@ -35,8 +36,7 @@ public:
   void step(network& _network)
   {
     auto& nodes = _network.getNodes();
-    auto& positions = nodes.positions();
-    auto& forces = nodes.forces();
+    const auto& forces = nodes.forces();
 
     m_dt = m_nextDt;
     double q = m_params.qMin;
@@ -45,20 +45,24 @@ public:
     bool error = false;
     bool qGood = false;
 
-    m_rk = positions;
+    m_rk = std::as_const(nodes).positions();
     m_frk = forces;
     while (iter++ < m_params.maxInnerIter) {
       const double overdampedScale = m_dt * m_invZeta;
 
+      auto& rbar = nodes.positions();
 #pragma omp parallel for schedule(static)
       for (size_t i = 0; i < nodes.size(); i++) {
-        positions[i] += forces[i] * overdampedScale;  // eq 8
+        rbar[i] += forces[i] * overdampedScale;  // eq 8
       }
       // Pos = r_{k+1}bar
 
       _network.computeForces();
       // forces = f(r_{k+1}bar)
 
+      // fetched again so the position generation moves past this evaluation
+      auto& positions = nodes.positions();
+
       const double halfOverdampedScale = 0.5 * overdampedScale;
       double estimatedError = -1e10;
 #pragma omp parallel for schedule(static) reduction(max : estimatedError)
@@ -33,6 +33,7 @@ public:
     const double Eoriginal = _network.getEnergy();
 
     double fdoth = Utils::Math::xdoty(_network.getNodes().forces(), _h);
+    const double fdothOriginal = fdoth;
     if (fdoth <= 0.0)
       return tl::make_unexpected(lineSearchState::DirectionNotDescent);
 
@@ -71,8 +72,9 @@ public:
           return alpha0;
       }
 
-      double dEIdeal = -quadConfig::backTrackSlope * alpha * fdoth;
-      double dE = Ecurr - Eprev;
+      // Armijo condition against the starting point
+      double dEIdeal = -quadConfig::backTrackSlope * alpha * fdothOriginal;
+      double dE = Ecurr - Eoriginal;
       if (dE < dEIdeal)
         return alpha;
 
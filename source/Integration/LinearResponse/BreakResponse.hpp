@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+#include "Core/Network.hpp"
+#include "Hessian.hpp"
+#include "Misc/Config.hpp"
+#include "Misc/Math/Matrix.hpp"
+#include "Misc/Math/SparseLDLT.hpp"
+#include "Misc/Math/Vector.hpp"
+
+namespace networkV4
+{
+namespace linearResponse
+{
+
+// Linear response of an equilibrated network to removing a single bond.
+// The Hessian H is factorised once; removing a bond with stiffness K is the
+// rank-2 update H - B^T K B, where B u = u_src - u_dst, so the response
+// is found with the Woodbury identity and three solves against H.
+class breakSolver
+{
+public:
+  breakSolver() = default;
+  breakSolver(double _shift)
+      : m_shift(_shift)
+  {
+  }
+
+public:
+  // Factorises the Hessian of _network, which should be at equilibrium
+  auto factorise(const network& _network) -> bool
+  {
+    m_factorised = factoriseHessian(_network, m_ldlt, m_shift);
+    return m_factorised;
+  }
+
+  // Displacement of the nodes once bond _index is removed, evaluated before
+  // the bond is broken. Returns nullopt if the bond carries the whole load
+  // of part of the network (the update is singular).
+  auto solve(network& _network, size_t _index) const
+      -> std::optional<std::vector<Utils::Math::vec2d>>
+  {
+    if (!m_factorised) {
+      return std::nullopt;
+    }
+
+    const auto& bonds = _network.getBonds();
+    const auto& bond = bonds.getBonds()[_index];
+    const auto& type = bonds.getTypes()[_index];
+    const auto& positions = _network.getNodes().positions();
+    const auto dist = _network.getBox().minDist(positions[bond.src],
+                                                positions[bond.dst]);
+
+    const auto K = bonded::visitStiffness(type, dist);
+    const auto F = bonded::visitForce(type, dist);
+    if (!K || !F) {
+      return std::vector<Utils::Math::vec2d>(
+          positions.size(), Utils::Math::vec2d({0.0, 0.0}));
+    }
+
+    // out of balance force once the bond has gone
+    _network.computeForces();
+    const auto& forces = _network.getNodes().forces();
+    std::vector<double> u0(2 * forces.size());
+    for (size_t i = 0; i < forces.size(); i++) {
+      u0[2 * i] = forces[i][0];
+      u0[2 * i + 1] = forces[i][1];
+    }
+    for (size_t dim = 0; dim < 2; dim++) {
+      u0[2 * bond.src + dim] -= F.value()[dim];
+      u0[2 * bond.dst + dim] += F.value()[dim];
+    }
+    m_ldlt.solve(u0);
+
+    // W = H^-1 B^T and C = B W
+    std::array<std::vector<double>, 2> W;
+    Utils::Math::mat22d C;
+    for (size_t j = 0; j < 2; j++) {
+      W[j].assign(u0.size(), 0.0);
+      W[j][2 * bond.src + j] = 1.0;
+      W[j][2 * bond.dst + j] = -1.0;
+      m_ldlt.solve(W[j]);
+      for (size_t dim = 0; dim < 2; dim++) {
+        C.m_data[2 * dim + j] =
+            W[j][2 * bond.src + dim] - W[j][2 * bond.dst + dim];
+      }
+    }
+
+    // s = (I - K C)^-1 K B u0
+    const auto& k = K.value();
+    const std::array<double, 2> Bu0 = {u0[2 * bond.src] - u0[2 * bond.dst],
+                                       u0[2 * bond.src + 1]
+                                           - u0[2 * bond.dst + 1]};
+    const std::array<double, 2> rhs = {k(0, 0) * Bu0[0] + k(0, 1) * Bu0[1],
+                                       k(1, 0) * Bu0[0] + k(1, 1) * Bu0[1]};
+    const double m00 = 1.0 - (k(0, 0) * C(0, 0) + k(0, 1) * C(1, 0));
+    const double m01 = -(k(0, 0) * C(0, 1) + k(0, 1) * C(1, 1));
+    const double m10 = -(k(1, 0) * C(0, 0) + k(1, 1) * C(1, 0));
+    const double m11 = 1.0 - (k(1, 0) * C(0, 1) + k(1, 1) * C(1, 1));
+    const double det = m00 * m11 - m01 * m10;
+    if (std::abs(det) < config::linearResponse::singularTol) {
+      return std::nullopt;
+    }
+    const double s0 = (m11 * rhs[0] - m01 * rhs[1]) / det;
+    const double s1 = (m00 * rhs[1] - m10 * rhs[0]) / det;
+
+    std::vector<Utils::Math::vec2d> displacement(forces.size());
+    for (size_t i = 0; i < forces.size(); i++) {
+      displacement[i] = Utils::Math::vec2d(
+          {u0[2 * i] + s0 * W[0][2 * i] + s1 * W[1][2 * i],
+           u0[2 * i + 1] + s0 * W[0][2 * i + 1] + s1 * W[1][2 * i + 1]});
+    }
+    return displacement;
+  }
+
+private:
+  double m_shift = config::linearResponse::shift;
+  bool m_factorised = false;
+  Utils::Math::sparseLDLT m_ldlt;
+};
+
+}  // namespace linearResponse
+}  // namespace networkV4
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <algorithm>
+
+#include "Core/Network.hpp"
+#include "Misc/Config.hpp"
+#include "Misc/Math/SparseLDLT.hpp"
+
+namespace networkV4
+{
+namespace linearResponse
+{
+
+// Factorises the Hessian of _network with a diagonal shift of _shift times
+// the mean diagonal, which regularises the translation and rattler modes
+inline auto factoriseHessian(const network& _network,
+                             Utils::Math::sparseLDLT& _ldlt,
+                             double _shift = config::linearResponse::shift)
+    -> bool
+{
+  const auto hessian = _network.assembleHessian();
+  double trace = 0.0;
+  for (size_t i = 0; i < hessian.rows; i++) {
+    trace += hessian.values[hessian.find(i, i)];
+  }
+  const double meanDiagonal = trace / std::max<size_t>(hessian.rows, 1);
+  return _ldlt.factorise(hessian, _shift * std::max(meanDiagonal, 1.0));
+}
+
+}  // namespace linearResponse
+}  // namespace networkV4
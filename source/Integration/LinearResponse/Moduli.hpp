@@ -0,0 +1,74 @@
+#pragma once
+
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include "Core/Network.hpp"
+#include "Hessian.hpp"
+#include "Misc/Config.hpp"
+#include "Misc/Math/Matrix.hpp"
+#include "Misc/Math/SparseLDLT.hpp"
+#include "Misc/Math/Vector.hpp"
+
+namespace networkV4
+{
+namespace linearResponse
+{
+
+struct elasticModuli
+{
+  double shear;
+  double bulk;
+  double affineShear;
+  double affineBulk;
+};
+
+// Zero temperature moduli of an equilibrated network. For a strain mode E
+// the relaxed curvature is U'' = U''_affine - Xi^T H^-1 Xi, with
+// Xi = d2U/dx deps; the Hessian is factorised once for both modes.
+//   shear : G = U''_xy / A
+//   bulk  : B = (U''_iso - U'_iso) / 4A, from A = A0 (1 + eps)^2
+inline auto computeModuli(const network& _network,
+                          double _shift = config::linearResponse::shift)
+    -> std::optional<elasticModuli>
+{
+  Utils::Math::sparseLDLT ldlt;
+  if (!factoriseHessian(_network, ldlt, _shift)) {
+    return std::nullopt;
+  }
+
+  auto relaxed = [&](const Utils::Math::mat22d& _E)
+      -> std::tuple<double, double, double>
+  {
+    std::vector<Utils::Math::vec2d> xi;
+    const auto [dU, d2U] = _network.computeStrainDerivatives(_E, xi);
+
+    std::vector<double> x(2 * xi.size());
+    for (size_t i = 0; i < xi.size(); i++) {
+      x[2 * i] = xi[i][0];
+      x[2 * i + 1] = xi[i][1];
+    }
+    ldlt.solve(x);
+
+    double nonAffine = 0.0;
+    for (size_t i = 0; i < xi.size(); i++) {
+      nonAffine += xi[i][0] * x[2 * i] + xi[i][1] * x[2 * i + 1];
+    }
+    return {dU, d2U, d2U - nonAffine};
+  };
+
+  const double area = _network.getBox().area();
+  const auto [stress, affineShear, shear] =
+      relaxed(Utils::Math::mat22d({0.0, 1.0, 0.0, 0.0}));
+  const auto [dUBulk, affineBulk, bulk] =
+      relaxed(Utils::Math::mat22d({1.0, 0.0, 0.0, 1.0}));
+
+  return elasticModuli {shear / area,
+                        (bulk - dUBulk) / (4.0 * area),
+                        affineShear / area,
+                        (affineBulk - dUBulk) / (4.0 * area)};
+}
+
+}  // namespace linearResponse
+}  // namespace networkV4
@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "Core/Network.hpp"
+#include "Integration/Integrators/Adaptive.hpp"
+#include "MinimiserBase.hpp"
+#include "Misc/Config.hpp"
+
+namespace networkV4
+{
+namespace minimisation
+{
+
+struct activeSetParams
+{
+  activeSetParams() = default;
+  activeSetParams(double _frontierTol, double _localTol, double _maxFraction)
+      : frontierTol(_frontierTol)
+      , localTol(_localTol)
+      , maxFraction(_maxFraction)
+  {
+  }
+  double frontierTol = config::integrators::activeSet::frontierTol;
+  double localTol = config::integrators::activeSet::localTol;
+  double maxFraction = config::integrators::activeSet::maxFraction;
+};
+
+enum class activeSetState : std::uint8_t
+{
+  converged,
+  broken,
+  spread,
+  maxIter,
+  failed,
+};
+
+// Overdamped adaptive Euler-Heun relaxation restricted to an active set of
+// nodes. Only active nodes move and only the forces on the halo (the active
+// nodes and their neighbours) are recomputed. A halo node joins the active set
+// once its force exceeds frontierTol * Ftol, so the set grows with the
+// disturbance. The network forces must be up to date when relax is called;
+// they are kept exact on return, the network energy is not.
+class activeSetRelax : public minimiserBase
+{
+public:
+  activeSetRelax() = default;
+  activeSetRelax(const minimiserParams& _minParams,
+                 const integration::AdaptiveParams& _stepParams,
+                 const activeSetParams& _params = activeSetParams())
+      : minimiserBase(_minParams)
+      , m_stepParams(_stepParams)
+      , m_params(_params)
+  {
+  }
+
+public:
+  // Relaxes around the nodes whose force is above the frontier tolerance
+  void minimise(network& _network) override
+  {
+    _network.computeForces();
+    clear();
+
+    const auto& forces = _network.getNodes().forces();
+    const double frontier2 = std::pow(m_params.frontierTol * m_Ftol, 2);
+    std::vector<size_t> seeds;
+    for (size_t i = 0; i < forces.size(); i++) {
+      if (forces[i].norm2() > frontier2) {
+        seeds.push_back(i);
+      }
+    }
+
+    relax(_network, seeds);
+  }
+
+  // Adds _seeds to the active set and relaxes. With _evalBreak, returns
+  // broken after a step in which bonds broke, leaving them in the break
+  // queue; call again to resume.
+  template <bool _evalBreak = false>
+  auto relax(network& _network, const std::vector<size_t>& _seeds)
+      -> activeSetState
+  {
+    setup(_network);
+    for (const auto node : _seeds) {
+      activate(node);
+    }
+
+    const size_t maxActive = static_cast<size_t>(
+        m_params.maxFraction * static_cast<double>(m_state.size()));
+    const double frontier2 = std::pow(m_params.frontierTol * m_Ftol, 2);
+    const double local2 = std::pow(m_params.localTol * m_Ftol, 2);
+    const auto& forces = _network.getNodes().forces();
+
+    while (m_iter++ < m_maxIter) {
+      if (m_active.size() > maxActive) {
+        return activeSetState::spread;
+      }
+
+      const double Eprev = activeEnergy(_network);
+      if (!step(_network)) {
+        return activeSetState::failed;
+      }
+      // The energy test is relative to the bonds that moved, not the network
+      const double Ecurr = activeEnergy(_network);
+
+      if constexpr (_evalBreak) {
+        if (checkBreaks(_network)) {
+          return activeSetState::broken;
+        }
+      }
+
+      bool grown = false;
+      double fdotf = 0.0;
+      for (const auto node : m_halo) {
+        const double f2 = forces[node].norm2();
+        fdotf += f2;
+        if (m_state[node] != nodeState::active && f2 > frontier2) {
+          activate(node);
+          grown = true;
+        }
+      }
+
+      if (!grown
+          && (fdotf < local2 || converged(fdotf, Ecurr, Eprev)))
+      {
+        return activeSetState::converged;
+      }
+    }
+    return activeSetState::maxIter;
+  }
+
+  // Empties the active set and resets the time and iteration count
+  void clear()
+  {
+    for (const auto node : m_halo) {
+      m_state[node] = nodeState::inactive;
+    }
+    m_active.clear();
+    m_halo.clear();
+    m_extended = 0;
+    m_time = 0.0;
+    m_iter = 0;
+    m_nextDt = config::integrators::default_dt;
+  }
+
+  auto getTime() const -> double { return m_time; }
+  auto getIterations() const -> size_t { return m_iter; }
+  auto getActiveCount() const -> size_t { return m_active.size(); }
+
+private:
+  enum class nodeState : std::uint8_t
+  {
+    inactive,
+    halo,
+    active,
+  };
+
+  // Node to bond incidence, rebuilt when the topology size changes. Broken
+  // bonds become virtual and stay in the list, so breaking needs no rebuild.
+  void setup(const network& _network)
+  {
+    const auto& bonds = _network.getBonds().getBonds();
+    const size_t N = _network.getNodes().size();
+    if (m_state.size() == N && m_incidence.size() == 2 * bonds.size()) {
+      return;
+    }
+
+    m_incidencePtr.assign(N + 1, 0);
+    for (const auto& bond : bonds) {
+      m_incidencePtr[bond.src + 1]++;
+      m_incidencePtr[bond.dst + 1]++;
+    }
+    std::partial_sum(
+        m_incidencePtr.begin(), m_incidencePtr.end(), m_incidencePtr.begin());
+    m_incidence.resize(m_incidencePtr[N]);
+    auto next = m_incidencePtr;
+    for (size_t i = 0; i < bonds.size(); i++) {
+      m_incidence[next[bonds[i].src]++] = i;
+      m_incidence[next[bonds[i].dst]++] = i;
+    }
+
+    m_state.assign(N, nodeState::inactive);
+    m_active.clear();
+    m_halo.clear();
+    m_extended = 0;
+  }
+
+  auto neighbour(const network& _network, size_t _node, size_t _bond) const
+      -> size_t
+  {
+    const auto& bond = _network.getBonds().getBonds()[_bond];
+    return bond.src == _node ? bond.dst : bond.src;
+  }
+
+  void activate(size_t _node)
+  {
+    if (m_state[_node] == nodeState::active) {
+      return;
+    }
+    if (m_state[_node] == nodeState::inactive) {
+      m_halo.push_back(_node);
+    }
+    m_state[_node] = nodeState::active;
+    m_active.push_back(_node);
+  }
+
+  // Adds the neighbours of newly active nodes to the halo
+  void extendHalo(const network& _network)
+  {
+    for (; m_extended < m_active.size(); m_extended++) {
+      const size_t node = m_active[m_extended];
+      for (size_t p = m_incidencePtr[node]; p < m_incidencePtr[node + 1]; p++)
+      {
+        const size_t other = neighbour(_network, node, m_incidence[p]);
+        if (m_state[other] == nodeState::inactive) {
+          m_state[other] = nodeState::halo;
+          m_halo.push_back(other);
+        }
+      }
+    }
+  }
+
+  void updateForces(network& _network) const
+  {
+    const auto& positions = _network.getNodes().positions();
+    auto& forces = _network.getNodes().forces();
+    const auto& bonds = _network.getBonds().getBonds();
+    const auto& types = _network.getBonds().getTypes();
+    const auto& box = _network.getBox();
+
+    for (const auto node : m_halo) {
+      Utils::Math::vec2d force({0.0, 0.0});
+      for (size_t p = m_incidencePtr[node]; p < m_incidencePtr[node + 1]; p++)
+      {
+        const auto& bond = bonds[m_incidence[p]];
+        const auto dist =
+            box.minDist(positions[bond.src], positions[bond.dst]);
+        const auto f = bonded::visitForce(types[m_incidence[p]], dist);
+        if (f) {
+          force += bond.src == node ? f.value() : -f.value();
+        }
+      }
+      forces[node] = force;
+    }
+  }
+
+  // Energy of the bonds with an active end, each counted once
+  auto activeEnergy(const network& _network) const -> double
+  {
+    const auto& positions = _network.getNodes().positions();
+    const auto& bonds = _network.getBonds().getBonds();
+    const auto& types = _network.getBonds().getTypes();
+    const auto& box = _network.getBox();
+
+    double energy = 0.0;
+    for (const auto node : m_active) {
+      for (size_t p = m_incidencePtr[node]; p < m_incidencePtr[node + 1]; p++)
+      {
+        const auto& bond = bonds[m_incidence[p]];
+        const size_t other = bond.src == node ? bond.dst : bond.src;
+        if (m_state[other] == nodeState::active && other < node) {
+          continue;
+        }
+        const auto dist =
+            box.minDist(positions[bond.src], positions[bond.dst]);
+        energy += bonded::visitEnergy(types[m_incidence[p]], dist).value_or(0.0);
+      }
+    }
+    return energy;
+  }
+
+  // Breaks among the bonds with an active end, activating both ends
+  auto checkBreaks(network& _network) -> bool
+  {
+    m_broken.clear();
+    for (const auto node : m_active) {
+      for (size_t p = m_incidencePtr[node]; p < m_incidencePtr[node + 1]; p++)
+      {
+        if (_network.checkBreak(m_incidence[p])) {
+          m_broken.push_back(m_incidence[p]);
+        }
+      }
+    }
+    if (m_broken.empty()) {
+      return false;
+    }
+    for (const auto bond : m_broken) {
+      activate(_network.getBonds().getBonds()[bond].src);
+      activate(_network.getBonds().getBonds()[bond].dst);
+    }
+    extendHalo(_network);
+    updateForces(_network);
+    return true;
+  }
+
+  // One adaptive Euler-Heun step of the active nodes, as in
+  // AdaptiveOverdampedEulerHeun with zeta = 1
+  auto step(network& _network) -> bool
+  {
+    extendHalo(_network);
+
+    auto& positions = _network.getNodes().positions();
+    auto& forces = _network.getNodes().forces();
+
+    m_rk.resize(m_active.size());
+    m_frk.resize(m_halo.size());
+    for (size_t a = 0; a < m_active.size(); a++) {
+      m_rk[a] = positions[m_active[a]];
+    }
+    for (size_t h = 0; h < m_halo.size(); h++) {
+      m_frk[h] = forces[m_halo[h]];
+    }
+    m_fActive.resize(m_active.size());
+    for (size_t a = 0; a < m_active.size(); a++) {
+      m_fActive[a] = forces[m_active[a]];
+    }
+
+    m_dt = m_nextDt;
+    double q = m_stepParams.qMin;
+    size_t iter = 0;
+    bool error = false;
+    while (iter++ < m_stepParams.maxInnerIter) {
+      for (size_t a = 0; a < m_active.size(); a++) {
+        positions[m_active[a]] += m_fActive[a] * m_dt;
+      }
+      updateForces(_network);
+
+      const double halfDt = 0.5 * m_dt;
+      double estimatedError = -1e10;
+      for (size_t a = 0; a < m_active.size(); a++) {
+        const size_t node = m_active[a];
+        positions[node] = m_rk[a] + halfDt * (m_fActive[a] + forces[node]);
+        const double E = (forces[node] - m_fActive[a]).norm() * halfDt;
+        const double tau = m_stepParams.espAbs
+            + m_stepParams.espRel * (positions[node] - m_rk[a]).norm();
+        estimatedError = std::max(estimatedError, E / tau);
+      }
+
+      q = std::clamp(std::pow(0.5 / estimatedError, 2),
+                     m_stepParams.qMin,
+                     m_stepParams.qMax);
+      error = std::isnan(q) || (m_dt == m_stepParams.dtMin && q < 1.0);
+      if (q > 1.0 || error) {
+        break;
+      }
+
+      for (size_t a = 0; a < m_active.size(); a++) {
+        positions[m_active[a]] = m_rk[a];
+      }
+      for (size_t h = 0; h < m_halo.size(); h++) {
+        forces[m_halo[h]] = m_frk[h];
+      }
+      m_dt *= q;
+    }
+    if (error || iter >= m_stepParams.maxInnerIter) {
+      for (size_t a = 0; a < m_active.size(); a++) {
+        positions[m_active[a]] = m_rk[a];
+      }
+      for (size_t h = 0; h < m_halo.size(); h++) {
+        forces[m_halo[h]] = m_frk[h];
+      }
+      return false;
+    }
+
+    updateForces(_network);
+    m_time += m_dt;
+    m_nextDt = std::clamp(m_dt * q, m_stepParams.dtMin, m_stepParams.dtMax);
+    return true;
+  }
+
+private:
+  integration::AdaptiveParams m_stepParams = integration::AdaptiveParams();
+  activeSetParams m_params = activeSetParams();
+
+  std::vector<size_t> m_incidencePtr;
+  std::vector<size_t> m_incidence;
+
+  std::vector<nodeState> m_state;
+  std::vector<size_t> m_active;
+  std::vector<size_t> m_halo;  // active nodes and their neighbours
+  size_t m_extended = 0;  // active nodes whose neighbours are in the halo
+  std::vector<size_t> m_broken;
+
+  std::vector<Utils::Math::vec2d> m_rk;
+  std::vector<Utils::Math::vec2d> m_frk;
+  std::vector<Utils::Math::vec2d> m_fActive;
+
+  double m_dt = config::integrators::default_dt;
+  double m_nextDt = config::integrators::default_dt;
+  double m_time = 0.0;
+  size_t m_iter = 0;
+};
+
+}  // namespace minimisation
+}  // namespace networkV4
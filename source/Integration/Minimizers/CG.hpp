@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+#include <numeric>
+
+#include "Integration/LineSearch/LineSearchQuad.hpp"
+#include "Integration/Preconditioners/BlockJacobi.hpp"
+#include "MinimiserBase.hpp"
+#include "Misc/Math/Misc.hpp"
+#include "Misc/Utils.hpp"
+
+namespace networkV4
+{
+namespace minimisation
+{
+
+struct CGParams
+{
+  CGParams() = default;
+  CGParams(cgBeta _beta,
+           double _alphaMax = config::integrators::cg::alphaMax,
+           double _restartThreshold = config::integrators::cg::restartThreshold,
+           size_t _restartInterval = config::integrators::cg::restartInterval,
+           double _hzEta = config::integrators::cg::hzEta)
+      : beta(_beta)
+      , alphaMax(_alphaMax)
+      , restartThreshold(_restartThreshold)
+      , restartInterval(_restartInterval)
+      , hzEta(_hzEta)
+  {
+  }
+  cgBeta beta = cgBeta::PolakRibierePlus;
+  double alphaMax = config::integrators::cg::alphaMax;
+  double restartThreshold = config::integrators::cg::restartThreshold;
+  size_t restartInterval = config::integrators::cg::restartInterval;
+  double hzEta = config::integrators::cg::hzEta;
+};
+
+// Nonlinear conjugate gradient using the quadratic line search. Only the
+// search direction and the previous force are stored, so memory is O(N).
+// With a preconditioner P the betas use z = P^-1 f in place of f.
+class CG : public minimiserBase
+{
+public:
+  CG() = default;
+  CG(double Ftol, double Etol, size_t maxIter, const CGParams& _params)
+      : minimiserBase(Ftol, Etol, maxIter)
+      , m_params(_params)
+  {
+  }
+
+  CG(const minimiserParams& _minParams,
+     const CGParams& _params = CGParams())
+      : minimiserBase(_minParams)
+      , m_params(_params)
+  {
+  }
+
+  void setPreconditioner(std::shared_ptr<preconditioner::blockJacobi> _precond)
+  {
+    m_precond = std::move(_precond);
+  }
+
+public:
+  void minimise(network& _network) override
+  {
+    auto lineSearch = lineSearch::lineSearchQuad(m_params.alphaMax);
+
+    const auto& forces = _network.getNodes().forces();
+    _network.computeForces();
+
+    double fdotf = Utils::Math::xdoty(forces, forces);
+    if (fdotf < m_Ftol * m_Ftol)
+      return;
+
+    const size_t restartInterval = m_params.restartInterval > 0
+        ? m_params.restartInterval
+        : 2 * _network.getNodes().size();
+
+    if (m_precond) {
+      m_precond->update(_network);
+      m_precond->apply(forces, m_z);
+    }
+    const auto& z = m_precond ? m_z : forces;
+
+    m_h = z;
+    m_fprev = forces;
+    double zprevdotfprev = Utils::Math::xdoty(z, forces);
+    size_t sinceRestart = 0;
+
+    double Ecurr = _network.getEnergy();
+    double Eprev = Ecurr;
+
+    for (size_t iter = 0; iter < m_maxIter; iter++) {
+      Eprev = Ecurr;
+      auto state = lineSearch.search(m_h, _network);
+      if (!state) {
+        if (state.error() == lineSearch::lineSearchState::zeroforce)
+          break;
+        if (sinceRestart == 0)
+          throw std::runtime_error("Line search failed");
+        // Fall back to steepest descent and try again
+        m_h = z;
+        sinceRestart = 0;
+        continue;
+      }
+
+      _network.computeForces();
+      Ecurr = _network.getEnergy();
+      fdotf = Utils::Math::xdoty(forces, forces);
+      if (converged(fdotf, Ecurr, Eprev))
+        break;
+
+      if (m_precond) {
+        m_precond->apply(forces, m_z);
+      }
+      const double zdotf = Utils::Math::xdoty(z, forces);
+      const double zdotfprev = Utils::Math::xdoty(z, m_fprev);
+      double beta = 0.0;
+      if (++sinceRestart < restartInterval
+          && std::abs(zdotfprev) < m_params.restartThreshold * zdotf)
+      {
+        beta = computeBeta(forces, zdotf, zdotfprev, zprevdotfprev);
+      } else {
+        sinceRestart = 0;
+      }
+
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < m_h.size(); i++) {
+        m_h[i] = z[i] + beta * m_h[i];
+      }
+
+      if (Utils::Math::xdoty(forces, m_h) <= 0.0) {
+        m_h = z;
+        sinceRestart = 0;
+      }
+
+      m_fprev = forces;
+      zprevdotfprev = zdotf;
+    }
+  }
+
+private:
+  // forces are the negative gradient, so with g = -f, y = g - gprev and
+  // z = P^-1 f (z = f without a preconditioner):
+  // PR+ : beta = max(0, z.(f - fprev) / zprev.fprev)
+  // HZ  : beta = (P^-1 y - 2 h |y|_P^2 / h.y).g / h.y, bounded below by eta
+  auto computeBeta(const std::vector<Utils::Math::vec2d>& _forces,
+                   double _zdotf,
+                   double _zdotfprev,
+                   double _zprevdotfprev) const -> double
+  {
+    switch (m_params.beta) {
+      case cgBeta::PolakRibierePlus:
+        return std::max(0.0, (_zdotf - _zdotfprev) / _zprevdotfprev);
+      case cgBeta::HagerZhang: {
+        const double hdotf = Utils::Math::xdoty(m_h, _forces);
+        const double hdoty = Utils::Math::xdoty(m_h, m_fprev) - hdotf;
+        if (std::abs(hdoty) < ROUND_ERROR_PRECISION)
+          return 0.0;
+        const double ydoty = _zprevdotfprev - 2.0 * _zdotfprev + _zdotf;
+        const double ydotg = _zdotf - _zdotfprev;
+        const double hdotg = -hdotf;
+        const double beta = (ydotg - 2.0 * ydoty * hdotg / hdoty) / hdoty;
+
+        const double hnorm = std::sqrt(Utils::Math::xdoty(m_h, m_h));
+        const double eta = -1.0
+            / (hnorm * std::min(m_params.hzEta, std::sqrt(_zprevdotfprev)));
+        return std::max(beta, eta);
+      }
+      default:
+        throw std::runtime_error("Unknown CG beta");
+    }
+  }
+
+private:
+  CGParams m_params = CGParams();
+  std::vector<Utils::Math::vec2d> m_h;
+  std::vector<Utils::Math::vec2d> m_fprev;
+
+  std::shared_ptr<preconditioner::blockJacobi> m_precond;
+  std::vector<Utils::Math::vec2d> m_z;
+};
+
+}  // namespace minimisation
+}  // namespace networkV4
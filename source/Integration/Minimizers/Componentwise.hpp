@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Integration/Preconditioners/BlockJacobi.hpp"
+#include "MinimiserBase.hpp"
+
+namespace networkV4
+{
+namespace minimisation
+{
+
+// Copies of the components of a network, kept between relaxations. A copy,
+// with its bond list, its cut-down partitions, its force caches and its own
+// preconditioner, is only built when the components change: when bonds break
+// or bonds::structure changes. Otherwise it only takes the positions and box
+// of the network being relaxed.
+class componentCopies
+{
+public:
+  struct entry
+  {
+    std::vector<size_t> members;  // sorted, a node's rank is its copy index
+    network copy;
+    // The network's partitions cut down to the copy
+    std::shared_ptr<const OMP::context> partitioned;
+    std::shared_ptr<preconditioner::blockJacobi> precond;
+  };
+
+  componentCopies() = default;
+
+public:
+  // Copy of component _c of _network at its current positions and box
+  auto get(const network& _network, size_t _c) -> entry&
+  {
+    sync(_network);
+    const auto& parts = _network.getComponents();
+    auto& slot = m_entries[_c];
+    if (slot && slot->members == parts.members(_c)) {
+      slot->copy.setBox(_network.getBox());
+      auto& relaxed = slot->copy.getNodes().positions();
+      const auto& positions = _network.getNodes().positions();
+      for (size_t j = 0; j < slot->members.size(); j++) {
+        relaxed[j] = positions[slot->members[j]];
+      }
+      return *slot;
+    }
+
+    const auto& members = parts.members(_c);
+    const auto bonds = parts.liveBonds(_c);
+    slot = std::make_unique<entry>(
+        entry {members,
+               extract(_network, members, bonds),
+               restrict(_network.getContext(), members, bonds),
+               std::make_shared<preconditioner::blockJacobi>()});
+    return *slot;
+  }
+
+private:
+  // Drops every copy if the components or the partitions of _network are not
+  // those the copies were made from
+  void sync(const network& _network)
+  {
+    const auto& context = _network.getContext();
+    if (m_brokenHash == _network.getBrokenHash()
+        && m_structure == _network.getBonds().structure()
+        && m_nodes == _network.getNodes().size()
+        && m_passes == context.passes() && m_threads == context.threads()
+        && samePartitions(context.partitions()))
+    {
+      return;
+    }
+    m_brokenHash = _network.getBrokenHash();
+    m_structure = _network.getBonds().structure();
+    m_nodes = _network.getNodes().size();
+    m_passes = context.passes();
+    m_threads = context.threads();
+    m_partitions = context.partitions();
+    m_entries.clear();
+    m_entries.resize(_network.getComponents().count());
+  }
+
+  auto samePartitions(const partition::Partitions& _partitions) const -> bool
+  {
+    return std::equal(
+        _partitions.begin(),
+        _partitions.end(),
+        m_partitions.begin(),
+        m_partitions.end(),
+        [](const partition::Partition& _a, const partition::Partition& _b)
+        {
+          return _a.index() == _b.index() && _a.nodeStart() == _b.nodeStart()
+              && _a.nodeEnd() == _b.nodeEnd()
+              && _a.bondStart() == _b.bondStart()
+              && _a.bondEnd() == _b.bondEnd();
+        });
+  }
+
+  // The partitions of _context cut down to the copy of _members and _bonds.
+  // Both are sorted, so every partition keeps a contiguous range and bonds
+  // keep their passes.
+  static auto restrict(const OMP::context& _context,
+                       const std::vector<size_t>& _members,
+                       const std::vector<size_t>& _bonds)
+      -> std::shared_ptr<const OMP::context>
+  {
+    auto rank = [](const std::vector<size_t>& _sorted, size_t _i) -> size_t
+    {
+      return std::lower_bound(_sorted.begin(), _sorted.end(), _i)
+          - _sorted.begin();
+    };
+    partition::Partitions partitions;
+    partitions.reserve(_context.partitions().size());
+    for (const auto& part : _context.partitions()) {
+      partitions.emplace_back(part.index(),
+                              rank(_members, part.nodeStart()),
+                              rank(_members, part.nodeEnd()),
+                              rank(_bonds, part.bondStart()),
+                              rank(_bonds, part.bondEnd()));
+    }
+    return std::make_shared<const OMP::context>(
+        std::move(partitions), _context.passes(), _context.threads());
+  }
+
+  // Network of _members and the live bonds _bonds between them alone
+  static auto extract(const network& _network,
+                      const std::vector<size_t>& _members,
+                      const std::vector<size_t>& _bonds) -> network
+  {
+    network copy(_network.getBox(), _members.size(), _bonds.size());
+
+    const auto& nodes = _network.getNodes();
+    for (const size_t n : _members) {
+      copy.getNodes().addNode(
+          nodes.positions()[n], nodes.velocities()[n], nodes.masses()[n]);
+    }
+
+    // Members are sorted, so a node's index in the copy is its rank there
+    auto local = [&](size_t _n) -> size_t
+    {
+      return std::lower_bound(_members.begin(), _members.end(), _n)
+          - _members.begin();
+    };
+    const auto& source = _network.getBonds();
+    for (const size_t i : _bonds) {
+      const auto& bond = source.getBonds()[i];
+      copy.getBonds().addBond(local(bond.src),
+                              local(bond.dst),
+                              source.getTypes()[i],
+                              source.getBreaks()[i],
+                              source.getTags()[i]);
+    }
+    return copy;
+  }
+
+private:
+  std::uint64_t m_brokenHash = 0;
+  std::uint64_t m_structure = 0;
+  size_t m_nodes = 0;
+  size_t m_passes = 0;
+  size_t m_threads = 0;
+  partition::Partitions m_partitions;
+  std::vector<std::unique_ptr<entry>> m_entries;  // per component
+};
+
+// Relaxes the connected components of a network apart, so a floppy cluster
+// does not hold back the rest. Components already within Ftol are skipped,
+// and nodes without live bonds carry no load and are never moved. A loaded
+// component with no other bonded component beside it is relaxed in place.
+// Otherwise each loaded component is relaxed in its copy, until its own
+// forces meet Ftol, and the positions are written back, so the bonds of
+// unloaded components are never evaluated. The largest copy keeps the
+// network's partitions and team, the others run a thread each. The forces of
+// the network are left to its next computeForces once copies were relaxed.
+class componentwise : public minimiserBase
+{
+public:
+  using factory = std::function<std::unique_ptr<minimiserBase>(
+      std::shared_ptr<preconditioner::blockJacobi>)>;
+
+  // _make gives a minimiser using the given preconditioner. _precond serves
+  // relaxations in place and _copies the components relaxed apart, both are
+  // made if not given.
+  componentwise(const minimiserParams& _params,
+                factory _make,
+                std::shared_ptr<preconditioner::blockJacobi> _precond = nullptr,
+                std::shared_ptr<componentCopies> _copies = nullptr)
+      : minimiserBase(_params)
+      , m_make(std::move(_make))
+      , m_precond(_precond ? std::move(_precond)
+                           : std::make_shared<preconditioner::blockJacobi>())
+      , m_copies(_copies ? std::move(_copies)
+                         : std::make_shared<componentCopies>())
+  {
+  }
+
+public:
+  void minimise(network& _network) override
+  {
+    const auto& parts = _network.getComponents();
+    _network.computeForces();
+
+    const auto& forces = _network.getNodes().forces();
+    std::vector<double> fdotf(parts.count(), 0.0);
+    for (size_t n = 0; n < forces.size(); n++) {
+      fdotf[parts.label(n)] += forces[n].norm2();
+    }
+
+    std::vector<size_t> loaded;
+    size_t bonded = 0;
+    for (size_t c = 0; c < parts.count(); c++) {
+      if (parts.members(c).size() > 1) {
+        bonded++;
+        if (fdotf[c] >= m_Ftol * m_Ftol) {
+          loaded.push_back(c);
+        }
+      }
+    }
+    if (loaded.empty()) {
+      return;
+    }
+    if (bonded == 1) {
+      m_make(m_precond)->minimise(_network);
+      return;
+    }
+
+    const auto largest = std::max_element(
+        loaded.begin(),
+        loaded.end(),
+        [&](size_t _a, size_t _b)
+        { return parts.members(_a).size() < parts.members(_b).size(); });
+    const size_t main = *largest;
+    loaded.erase(largest);
+
+    if (!loaded.empty()) {
+      relaxApart(_network, loaded);
+    }
+
+    auto& copy = m_copies->get(_network, main);
+    copy.copy.setContext(copy.partitioned);
+    m_make(copy.precond)->minimise(copy.copy);
+    writeBack(_network, copy);
+  }
+
+private:
+  void relaxApart(network& _network, const std::vector<size_t>& _loaded)
+  {
+    // One thread per component, their force loops run serially
+    const auto serial = std::make_shared<const OMP::context>(
+        partition::Partitions {}, 1, 1);
+    std::vector<componentCopies::entry*> copies;
+    copies.reserve(_loaded.size());
+    for (const size_t c : _loaded) {
+      copies.push_back(&m_copies->get(_network, c));
+      copies.back()->copy.setContext(serial);
+    }
+
+    std::exception_ptr error;
+#pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < copies.size(); i++) {
+      try {
+        m_make(copies[i]->precond)->minimise(copies[i]->copy);
+      } catch (...) {
+#pragma omp critical
+        error = std::current_exception();
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+
+    for (const auto* copy : copies) {
+      writeBack(_network, *copy);
+    }
+  }
+
+  static void writeBack(network& _network,
+                        const componentCopies::entry& _copy)
+  {
+    auto& positions = _network.getNodes().positions();
+    const auto& relaxed = _copy.copy.getNodes().positions();
+    for (size_t j = 0; j < _copy.members.size(); j++) {
+      positions[_copy.members[j]] = relaxed[j];
+    }
+  }
+
+private:
+  factory m_make;
+  std::shared_ptr<preconditioner::blockJacobi> m_precond;
+  std::shared_ptr<componentCopies> m_copies;
+};
+
+}  // namespace minimisation
+}  // namespace networkV4
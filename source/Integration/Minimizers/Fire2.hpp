@@ -1,9 +1,11 @@
 #pragma once
 
+#include <memory>
 #include <numeric>
 
 #include <range/v3/view/zip.hpp>
 
+#include "Integration/Preconditioners/BlockJacobi.hpp"
 #include "MinimiserBase.hpp"
 #include "Misc/Math/Misc.hpp"
 #include "Misc/Utils.hpp"
@@ -75,6 +77,12 @@ public:
   {
   }
 
+  // Uses the block-Jacobi preconditioner as the mass matrix
+  void setPreconditioner(std::shared_ptr<preconditioner::blockJacobi> _precond)
+  {
+    m_precond = std::move(_precond);
+  }
+
 public:
   void minimise(network& _network) override
   {
@@ -89,7 +97,6 @@ public:
 
     nodes& nodes = _network.getNodes();
     auto& vels = nodes.velocities();
-    auto& pos = _network.getNodes().positions();
 
     _network.computeForces();
     double Eprev = _network.getEnergy();
@@ -100,10 +107,19 @@ public:
       return;
     }
 
+    // With a preconditioner P the dynamics are P dv/dt = f, so the
+    // preconditioned force replaces f / m in the updates below
+    if (m_precond) {
+      m_precond->update(_network);
+      m_precond->apply(forces, m_pforces);
+    }
+    const auto& accel = m_precond ? m_pforces : forces;
+
     nodes.zeroVelocity();
 
     size_t iter = 0;
     while (iter++ < m_maxIter) {
+      auto& pos = nodes.positions();
       vdotf = Utils::Math::xdoty(vels, forces);
 
       if (vdotf > 0.0) {
@@ -111,7 +127,7 @@ public:
         Nneg = 0;
 
         vdotv = Utils::Math::xdoty(vels, vels);
-        fdotf = Utils::Math::xdoty(forces, forces);
+        fdotf = Utils::Math::xdoty(accel, accel);
 
         if (m_params.abc) {
           alpha = std::max(alpha, 1e-10);
@@ -151,10 +167,10 @@ public:
       double vmax = m_params.dmax / m_dt;
 #pragma omp parallel for schedule(static)
       for (size_t i = 0; i < vels.size(); i++) {
-        double fscale = m_dt / masses[i];
-        vels[i] += fscale * forces[i];
+        double fscale = m_precond ? m_dt : m_dt / masses[i];
+        vels[i] += fscale * accel[i];
         if (vdotf > 0.0) {
-          vels[i] = scale1 * vels[i] + scale2 * forces[i];
+          vels[i] = scale1 * vels[i] + scale2 * accel[i];
           if (m_params.abc) {
             // make sure that the displacement is not larger than dmax
             std::transform(vels[i].begin(),
@@ -170,6 +186,9 @@ public:
       Eprev = Ecurr;
       _network.computeForces();
       Ecurr = _network.getEnergy();
+      if (m_precond) {
+        m_precond->apply(forces, m_pforces);
+      }
 
       fdotf = Utils::Math::xdoty(forces, forces);
       if (Npos > m_params.Ndelay && converged(fdotf, Ecurr, Eprev)) {
@@ -190,6 +209,9 @@ public:
 private:
   Fire2Params m_params = Fire2Params();
   double m_dt = config::integrators::default_dt;
+
+  std::shared_ptr<preconditioner::blockJacobi> m_precond;
+  std::vector<Utils::Math::vec2d> m_pforces;
 };
 
 }  // namespace minimisation
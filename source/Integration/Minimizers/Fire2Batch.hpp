@@ -0,0 +1,224 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Core/Replicas.hpp"
+#include "Fire2.hpp"
+#include "MinimiserBase.hpp"
+
+namespace networkV4
+{
+namespace minimisation
+{
+
+// FIRE2 over every replica of a batch at once. Each replica keeps its own
+// time step, mixing and convergence, as if it were minimised alone by fire2
+// without a preconditioner, and stops moving once it has converged.
+class fire2Batch : public minimiserBase
+{
+public:
+  fire2Batch(const minimiserParams& _minParams,
+             const Fire2Params& _params = Fire2Params(),
+             double _dt = config::integrators::default_dt)
+      : minimiserBase(_minParams)
+      , m_params(_params)
+      , m_dt0(_dt)
+  {
+  }
+
+public:
+  void minimise(network& _network) override
+  {
+    replicaBatch batch(_network, 1);
+    minimise(batch);
+    batch.store(0, _network);
+  }
+
+  void minimise(replicaBatch& _batch)
+  {
+    const size_t R = _batch.replicas();
+    const size_t N = _batch.nodes();
+    const auto& forces = _batch.forces();
+    const auto& masses = _batch.masses();
+    auto& pos = _batch.positions();
+    auto& vels = _batch.velocities();
+
+    lanes lane(R, m_params.alpha0, m_dt0);
+    std::vector<double> vdotf(R), vdotv(R), fdotf(R);
+
+    _batch.computeForces();
+    for (size_t r = 0; r < R; r++) {
+      lane.Ecurr[r] = lane.Eprev[r] = _batch.energy(r);
+    }
+    dots(_batch, forces, forces, fdotf);
+    for (size_t r = 0; r < R; r++) {
+      lane.active[r] = fdotf[r] >= m_Ftol * m_Ftol;
+    }
+    std::fill(vels.begin(), vels.end(), 0.0);
+
+    size_t iter = 0;
+    while (iter++ < m_maxIter && lane.any()) {
+      dots(_batch, vels, forces, vdotf);
+      dots(_batch, vels, vels, vdotv);
+      dots(_batch, forces, forces, fdotf);
+
+      for (size_t r = 0; r < R; r++) {
+        lane.step[r] = 0.0;
+        lane.back[r] = 0.0;
+        lane.mix[r] = 0;
+        if (!lane.active[r]) {
+          continue;
+        }
+
+        if (vdotf[r] > 0.0) {
+          lane.Npos[r]++;
+          lane.Nneg[r] = 0;
+          lane.mix[r] = 1;
+
+          double& alpha = lane.alpha[r];
+          const double f2 = fdotf[r];
+          if (m_params.abc) {
+            alpha = std::max(alpha, 1e-10);
+            double abc = 1.0 - std::pow(1.0 - alpha, lane.Npos[r]);
+            lane.scale1[r] = (1.0 - alpha) / abc;
+            lane.scale2[r] =
+                f2 <= 1e-20 ? 0.0 : (alpha * std::sqrt(vdotv[r] / f2)) / abc;
+          } else {
+            lane.scale1[r] = 1.0 - alpha;
+            lane.scale2[r] =
+                f2 <= 1e-20 ? 0.0 : (alpha * std::sqrt(vdotv[r] / f2));
+          }
+
+          if (lane.Npos[r] > m_params.Ndelay) {
+            lane.dt[r] = std::min(lane.dt[r] * m_params.finc, m_params.dtMax);
+            alpha *= m_params.falpha;
+          }
+        } else {
+          lane.Nneg[r]++;
+          lane.Npos[r] = 0;
+
+          if (lane.Nneg[r] > m_params.Nnegmax) {
+            lane.active[r] = 0;
+            continue;
+          }
+          if (iter > m_params.Ndelay) {
+            lane.dt[r] = std::max(lane.dt[r] * m_params.fdec, m_params.dtMin);
+            lane.alpha[r] = m_params.alpha0;
+          }
+          lane.back[r] = 0.5 * lane.dt[r];
+        }
+        lane.step[r] = lane.dt[r];
+        lane.vmax[r] = m_params.dmax / lane.dt[r];
+      }
+
+      // Stopped replicas have a zero step and do not move
+      const bool abc = m_params.abc;
+      for (size_t n = 0; n < N; n++) {
+        const double invMass = 1.0 / masses[n];
+        for (size_t d = 0; d < 2; d++) {
+          const size_t offset = _batch.index(n, d, 0);
+          double* p = pos.data() + offset;
+          double* v = vels.data() + offset;
+          const double* f = forces.data() + offset;
+#pragma omp simd
+          for (size_t r = 0; r < R; r++) {
+            double vr = v[r];
+            p[r] -= lane.back[r] * vr;
+            vr = lane.back[r] > 0.0 ? 0.0 : vr;
+            vr += lane.step[r] * invMass * f[r];
+            if (lane.mix[r]) {
+              vr = lane.scale1[r] * vr + lane.scale2[r] * f[r];
+              if (abc) {
+                vr = std::clamp(vr, -lane.vmax[r], lane.vmax[r]);
+              }
+            }
+            p[r] += lane.step[r] * vr;
+            v[r] = vr;
+          }
+        }
+      }
+
+      _batch.computeForces();
+      dots(_batch, forces, forces, fdotf);
+      for (size_t r = 0; r < R; r++) {
+        lane.Eprev[r] = lane.Ecurr[r];
+        lane.Ecurr[r] = _batch.energy(r);
+        if (lane.active[r] && lane.Npos[r] > m_params.Ndelay
+            && converged(fdotf[r], lane.Ecurr[r], lane.Eprev[r]))
+        {
+          lane.active[r] = 0;
+        }
+      }
+    }
+  }
+
+private:
+  // Per replica state, as the locals of fire2::minimise
+  struct lanes
+  {
+    lanes(size_t _R, double _alpha0, double _dt)
+        : active(_R, 1)
+        , mix(_R, 0)
+        , Npos(_R, 0)
+        , Nneg(_R, 0)
+        , alpha(_R, _alpha0)
+        , dt(_R, _dt)
+        , step(_R, 0.0)
+        , back(_R, 0.0)
+        , scale1(_R, 0.0)
+        , scale2(_R, 0.0)
+        , vmax(_R, 0.0)
+        , Ecurr(_R, 0.0)
+        , Eprev(_R, 0.0)
+    {
+    }
+
+    auto any() const -> bool
+    {
+      return std::any_of(
+          active.begin(), active.end(), [](char _a) { return _a != 0; });
+    }
+
+    std::vector<char> active;
+    std::vector<char> mix;  // FIRE mixing this step, vdotf > 0
+    std::vector<size_t> Npos;
+    std::vector<size_t> Nneg;
+    std::vector<double> alpha;
+    std::vector<double> dt;
+    std::vector<double> step;  // dt, zero once stopped
+    std::vector<double> back;  // half step back after an uphill step
+    std::vector<double> scale1;
+    std::vector<double> scale2;
+    std::vector<double> vmax;
+    std::vector<double> Ecurr;
+    std::vector<double> Eprev;
+  };
+
+  // Per replica dot products of two batch arrays
+  static void dots(const replicaBatch& _batch,
+                   const std::vector<double>& _a,
+                   const std::vector<double>& _b,
+                   std::vector<double>& _out)
+  {
+    const size_t R = _batch.replicas();
+    std::fill(_out.begin(), _out.end(), 0.0);
+    double* out = _out.data();
+    for (size_t i = 0; i < _a.size(); i += R) {
+      const double* a = _a.data() + i;
+      const double* b = _b.data() + i;
+#pragma omp simd
+      for (size_t r = 0; r < R; r++) {
+        out[r] += a[r] * b[r];
+      }
+    }
+  }
+
+private:
+  Fire2Params m_params = Fire2Params();
+  double m_dt0 = config::integrators::default_dt;
+};
+
+}  // namespace minimisation
+}  // namespace networkV4
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "Core/Network.hpp"
 #include "Misc/Config.hpp"
 
@@ -10,11 +12,30 @@ namespace minimisation
 
 static constexpr double EPS_ENERGY = 1e-8;
 
+enum class minimiserType : std::uint8_t
+{
+  FIRE2,
+  SD,
+  CG,
+  NewtonCG,
+};
+
+enum class cgBeta : std::uint8_t
+{
+  PolakRibierePlus,
+  HagerZhang,
+};
+
 struct minimiserParams
 {
   double Ftol = config::integrators::miminizer::Ftol;
   double Etol = config::integrators::miminizer::Etol;
   size_t maxIter = config::integrators::miminizer::maxIter;
+
+  minimiserType type = minimiserType::FIRE2;
+  cgBeta beta = cgBeta::PolakRibierePlus;
+  bool precondition = false;  // block-Jacobi, used by FIRE2 and CG
+  bool components = false;  // relax connected components apart
 };
 
 class minimiserBase
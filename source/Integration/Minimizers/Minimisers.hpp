@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+
+#include "CG.hpp"
+#include "Componentwise.hpp"
+#include "Fire2.hpp"
+#include "MinimiserBase.hpp"
+#include "NewtonCG.hpp"
+#include "SD.hpp"
+
+namespace networkV4
+{
+namespace minimisation
+{
+
+// _precond is shared between calls so the blocks are only rebuilt when bonds
+// break; a fresh one is made if preconditioning is on and none is given.
+inline auto createSolver(
+    const minimiserParams& _params,
+    std::shared_ptr<preconditioner::blockJacobi> _precond = nullptr)
+    -> std::unique_ptr<minimiserBase>
+{
+  if (_params.precondition && !_precond) {
+    _precond = std::make_shared<preconditioner::blockJacobi>();
+  }
+  if (!_params.precondition) {
+    _precond = nullptr;
+  }
+
+  switch (_params.type) {
+    case minimiserType::FIRE2: {
+      auto fireParams = Fire2Params();
+      if (_precond) {
+        fireParams.dtMax = config::integrators::preconditioner::dtMax;
+      }
+      auto minimiser = std::make_unique<fire2>(_params, fireParams);
+      minimiser->setPreconditioner(_precond);
+      return minimiser;
+    }
+    case minimiserType::SD:
+      return std::make_unique<SD>(_params);
+    case minimiserType::CG: {
+      auto cgParams = CGParams(_params.beta);
+      if (_precond) {
+        cgParams.alphaMax = config::integrators::preconditioner::alphaMax;
+      }
+      auto minimiser = std::make_unique<CG>(_params, cgParams);
+      minimiser->setPreconditioner(_precond);
+      return minimiser;
+    }
+    case minimiserType::NewtonCG:
+      return std::make_unique<NewtonCG>(_params);
+    default:
+      throw std::runtime_error("Unknown minimiser type");
+  }
+}
+
+// As createSolver, run by component if requested. _precond is used when the
+// whole network is relaxed in place, and the copies in _copies, shared
+// between calls like _precond, keep a preconditioner each.
+inline auto createMinimiser(
+    const minimiserParams& _params,
+    std::shared_ptr<preconditioner::blockJacobi> _precond = nullptr,
+    std::shared_ptr<componentCopies> _copies = nullptr)
+    -> std::unique_ptr<minimiserBase>
+{
+  if (!_params.components) {
+    return createSolver(_params, std::move(_precond));
+  }
+
+  auto params = _params;
+  params.components = false;
+  return std::make_unique<componentwise>(
+      _params,
+      [params](std::shared_ptr<preconditioner::blockJacobi> _componentPrecond)
+      { return createSolver(params, std::move(_componentPrecond)); },
+      std::move(_precond),
+      std::move(_copies));
+}
+
+}  // namespace minimisation
+}  // namespace networkV4
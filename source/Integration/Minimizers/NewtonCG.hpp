@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include "MinimiserBase.hpp"
+#include "Misc/Math/Misc.hpp"
+#include "Misc/Utils.hpp"
+
+namespace networkV4
+{
+namespace minimisation
+{
+
+static constexpr double EPS_ENERGY_ROUNDOFF = 1e-12;
+
+struct NewtonCGParams
+{
+  NewtonCGParams() = default;
+  NewtonCGParams(double _initialRadius,
+                 double _maxRadius,
+                 double _acceptRatio,
+                 double _forcingMax,
+                 size_t _maxCGIter)
+      : initialRadius(_initialRadius)
+      , maxRadius(_maxRadius)
+      , acceptRatio(_acceptRatio)
+      , forcingMax(_forcingMax)
+      , maxCGIter(_maxCGIter)
+  {
+  }
+  double initialRadius = config::integrators::newtonCG::initialRadius;
+  double maxRadius = config::integrators::newtonCG::maxRadius;
+  double acceptRatio = config::integrators::newtonCG::acceptRatio;
+  double forcingMax = config::integrators::newtonCG::forcingMax;
+  size_t maxCGIter = config::integrators::newtonCG::maxCGIter;
+};
+
+// Truncated Newton with a Steihaug-Toint trust region. The Newton system
+// H p = f is solved approximately by CG using Hessian-vector products from
+// the network, so the Hessian is never assembled.
+class NewtonCG : public minimiserBase
+{
+public:
+  NewtonCG() = default;
+  NewtonCG(double Ftol,
+           double Etol,
+           size_t maxIter,
+           const NewtonCGParams& _params)
+      : minimiserBase(Ftol, Etol, maxIter)
+      , m_params(_params)
+  {
+  }
+
+  NewtonCG(const minimiserParams& _minParams,
+           const NewtonCGParams& _params = NewtonCGParams())
+      : minimiserBase(_minParams)
+      , m_params(_params)
+  {
+  }
+
+public:
+  void minimise(network& _network) override
+  {
+    const auto& forces = _network.getNodes().forces();
+    _network.computeForces();
+
+    double fdotf = Utils::Math::xdoty(forces, forces);
+    if (fdotf < m_Ftol * m_Ftol)
+      return;
+
+    double Ecurr = _network.getEnergy();
+    double Eprev = Ecurr;
+    double radius = m_params.initialRadius;
+
+    for (size_t iter = 0; iter < m_maxIter; iter++) {
+      // Eisenstat-Walker style forcing term gives superlinear convergence
+      const double fnorm = std::sqrt(fdotf);
+      const double tol = std::min(m_params.forcingMax, std::sqrt(fnorm)) * fnorm;
+      const bool onBoundary = steihaug(_network, forces, radius, tol);
+
+      // predicted reduction -m(p) = f.p - 1/2 p.Hp
+      _network.computeHessianProduct(m_p, m_Hd);
+      const double predicted =
+          Utils::Math::xdoty(forces, m_p) - 0.5 * Utils::Math::xdoty(m_p, m_Hd);
+
+      auto& pos = _network.getNodes().positions();
+      m_xprev = pos;
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < pos.size(); i++) {
+        pos[i] += m_p[i];
+      }
+      _network.computeForces();
+      const double actual = Ecurr - _network.getEnergy();
+
+      // Close to the minimum the energy change is lost in round off, so
+      // judge the step on the force instead
+      double rho = predicted > 0.0 ? actual / predicted : -1.0;
+      if (predicted < EPS_ENERGY_ROUNDOFF * std::abs(Ecurr)) {
+        rho = Utils::Math::xdoty(forces, forces) < fdotf ? 1.0 : -1.0;
+      }
+      if (rho < 0.25) {
+        radius *= 0.25;
+      } else if (rho > 0.75 && onBoundary) {
+        radius = std::min(2.0 * radius, m_params.maxRadius);
+      }
+
+      if (rho <= m_params.acceptRatio) {
+        _network.getNodes().positions() = m_xprev;
+        _network.computeForces();
+        if (radius < ROUND_ERROR_PRECISION)
+          throw std::runtime_error("NewtonCG: trust region collapsed");
+        continue;
+      }
+
+      Eprev = Ecurr;
+      Ecurr = _network.getEnergy();
+      fdotf = Utils::Math::xdoty(forces, forces);
+      if (converged(fdotf, Ecurr, Eprev))
+        break;
+    }
+  }
+
+private:
+  // Approximately solves H p = f within |p| <= _radius, leaving p in m_p.
+  // Returns true if the step was truncated at the trust region boundary.
+  auto steihaug(const network& _network,
+                const std::vector<Utils::Math::vec2d>& _forces,
+                double _radius,
+                double _tol) -> bool
+  {
+    const size_t maxCGIter = m_params.maxCGIter > 0
+        ? m_params.maxCGIter
+        : 2 * _forces.size();
+
+    m_p.assign(_forces.size(), Utils::Math::vec2d({0.0, 0.0}));
+    m_r = _forces;
+    m_d = _forces;
+    double rdotr = Utils::Math::xdoty(m_r, m_r);
+
+    for (size_t k = 0; k < maxCGIter && rdotr > _tol * _tol; k++) {
+      _network.computeHessianProduct(m_d, m_Hd);
+      const double dHd = Utils::Math::xdoty(m_d, m_Hd);
+      if (dHd <= 0.0) {
+        // negative curvature, follow d to the boundary
+        toBoundary(_radius);
+        return true;
+      }
+
+      const double alpha = rdotr / dHd;
+      const double pdotp = Utils::Math::xdoty(m_p, m_p);
+      const double pdotd = Utils::Math::xdoty(m_p, m_d);
+      const double ddotd = Utils::Math::xdoty(m_d, m_d);
+      if (pdotp + 2.0 * alpha * pdotd + alpha * alpha * ddotd
+          >= _radius * _radius)
+      {
+        toBoundary(_radius);
+        return true;
+      }
+
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < m_p.size(); i++) {
+        m_p[i] += alpha * m_d[i];
+        m_r[i] -= alpha * m_Hd[i];
+      }
+
+      const double rdotrNew = Utils::Math::xdoty(m_r, m_r);
+      const double beta = rdotrNew / rdotr;
+      rdotr = rdotrNew;
+
+#pragma omp parallel for schedule(static)
+      for (size_t i = 0; i < m_d.size(); i++) {
+        m_d[i] = m_r[i] + beta * m_d[i];
+      }
+    }
+    return false;
+  }
+
+  // p += tau d with tau > 0 such that |p| = _radius
+  void toBoundary(double _radius)
+  {
+    const double pdotp = Utils::Math::xdoty(m_p, m_p);
+    const double pdotd = Utils::Math::xdoty(m_p, m_d);
+    const double ddotd = Utils::Math::xdoty(m_d, m_d);
+    const double disc =
+        pdotd * pdotd + ddotd * (_radius * _radius - pdotp);
+    const double tau = (-pdotd + std::sqrt(std::max(disc, 0.0))) / ddotd;
+
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < m_p.size(); i++) {
+      m_p[i] += tau * m_d[i];
+    }
+  }
+
+private:
+  NewtonCGParams m_params = NewtonCGParams();
+  std::vector<Utils::Math::vec2d> m_p;
+  std::vector<Utils::Math::vec2d> m_r;
+  std::vector<Utils::Math::vec2d> m_d;
+  std::vector<Utils::Math::vec2d> m_Hd;
+  std::vector<Utils::Math::vec2d> m_xprev;
+};
+
+}  // namespace minimisation
+}  // namespace networkV4
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "Core/Network.hpp"
+#include "Misc/Config.hpp"
+#include "Misc/Math/Matrix.hpp"
+#include "Misc/Math/Vector.hpp"
+
+namespace networkV4
+{
+namespace preconditioner
+{
+
+// Per-node 2x2 block of the Hessian, built from the incident bonds and
+// inverted once. The blocks only change appreciably when the bond topology
+// does, so they are rebuilt when the set of broken bonds changes.
+class blockJacobi
+{
+public:
+  blockJacobi() = default;
+  blockJacobi(double _regularisation)
+      : m_regularisation(_regularisation)
+  {
+  }
+
+public:
+  // Rebuilds the blocks if _network has a different broken bond set
+  void update(const network& _network)
+  {
+    if (m_hash && m_hash.value() == _network.getBrokenHash()
+        && m_inverse.size() == _network.getNodes().size())
+    {
+      return;
+    }
+    rebuild(_network);
+  }
+
+  void rebuild(const network& _network)
+  {
+    const auto& positions = _network.getNodes().positions();
+    const auto& box = _network.getBox();
+    const auto& bonds = _network.getBonds();
+
+    std::vector<Utils::Math::mat22d> blocks(positions.size());
+    for (size_t i = 0; i < bonds.size(); i++) {
+      const auto& bond = bonds.getBonds()[i];
+      const auto& type = bonds.getTypes()[i];
+      const auto dist = box.minDist(positions[bond.src], positions[bond.dst]);
+
+      const auto K = bonded::visitStiffness(type, dist);
+      if (!K) {
+        continue;
+      }
+      for (const auto node : {bond.src, bond.dst}) {
+        auto& block = blocks[node].m_data;
+        for (size_t j = 0; j < 4; j++) {
+          block[j] += K.value().m_data[j];
+        }
+      }
+    }
+
+    m_inverse.resize(blocks.size());
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < blocks.size(); i++) {
+      m_inverse[i] = invertBlock(blocks[i]);
+    }
+    m_hash = _network.getBrokenHash();
+  }
+
+  // _z = P^-1 _f
+  void apply(const std::vector<Utils::Math::vec2d>& _f,
+             std::vector<Utils::Math::vec2d>& _z) const
+  {
+    _z.resize(_f.size());
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < _f.size(); i++) {
+      const auto& inv = m_inverse[i];
+      _z[i] = Utils::Math::vec2d({inv(0, 0) * _f[i][0] + inv(0, 1) * _f[i][1],
+                                  inv(1, 0) * _f[i][0] + inv(1, 1) * _f[i][1]});
+    }
+  }
+
+private:
+  // Inverse of the symmetric block with its eigenvalues floored at a
+  // fraction of the largest, which keeps compressed and dangling nodes
+  // positive definite
+  auto invertBlock(const Utils::Math::mat22d& _block) const
+      -> Utils::Math::mat22d
+  {
+    const double a = _block(0, 0);
+    const double b = 0.5 * (_block(0, 1) + _block(1, 0));
+    const double c = _block(1, 1);
+
+    const double mean = 0.5 * (a + c);
+    const double radius = std::hypot(0.5 * (a - c), b);
+    const double lmax = mean + radius;
+    if (lmax <= ROUND_ERROR_PRECISION) {
+      return Utils::Math::mat22d({1.0, 0.0, 0.0, 1.0});
+    }
+    const double floor = m_regularisation * lmax;
+    const double l1 = 1.0 / lmax;
+    const double l2 = 1.0 / std::max(mean - radius, floor);
+
+    const double theta = 0.5 * std::atan2(2.0 * b, a - c);
+    const double cs = std::cos(theta);
+    const double sn = std::sin(theta);
+    const double offDiag = (l1 - l2) * cs * sn;
+    return Utils::Math::mat22d({l1 * cs * cs + l2 * sn * sn,
+                                offDiag,
+                                offDiag,
+                                l1 * sn * sn + l2 * cs * cs});
+  }
+
+private:
+  double m_regularisation = config::integrators::preconditioner::regularisation;
+  std::optional<std::uint64_t> m_hash = std::nullopt;
+  std::vector<Utils::Math::mat22d> m_inverse;
+};
+
+}  // namespace preconditioner
+}  // namespace networkV4
@@ -17,6 +17,14 @@
 
 #define NUM_TAGS 4
 
+// Bond endpoints stored as 32 bit node indices, halving the bond stream the
+// force loop reads. Networks must have fewer than 2^32 nodes.
+#define COMPACT_TOPOLOGY 1
+
+// Force loops read bond parameters from a deduplicated table, see bondParams,
+// rather than from the per bond variants
+#define BOND_PARAM_TABLE 1
+
 namespace config
 {
 
@@ -71,6 +79,38 @@ inline std::size_t Nnegmax = 2000;
 inline double dmax = 0.1;
 }  // namespace fire2
 
+namespace cg
+{
+inline double alphaMax = 0.1;
+inline double restartThreshold = 0.2;  // Powell restart: |f.fprev| >= nu |f|^2
+inline std::size_t restartInterval = 0;  // 0 => number of degrees of freedom
+inline double hzEta = 0.01;
+}  // namespace cg
+
+namespace newtonCG
+{
+inline double initialRadius = 0.1;
+inline double maxRadius = 1.0;
+inline double acceptRatio = 0.1;
+inline double forcingMax = 0.5;
+inline std::size_t maxCGIter = 0;  // 0 => twice the number of nodes
+}  // namespace newtonCG
+
+namespace preconditioner
+{
+inline double regularisation = 1e-2;  // smallest eigenvalue / largest
+// preconditioned directions are displacements, so natural steps are O(1)
+inline double alphaMax = 1.0;
+inline double dtMax = 0.4;
+}  // namespace preconditioner
+
+namespace activeSet
+{
+inline double frontierTol = 0.1;  // node force to join the set / Ftol
+inline double localTol = 0.5;  // halo force for local convergence / Ftol
+inline double maxFraction = 0.5;  // hand over to a full relaxation above this
+}  // namespace activeSet
+
 namespace OverdampedAdaptiveMinimizer
 {
 inline double energyStepScale = 0.5;
@@ -93,6 +133,14 @@ inline double k2 = 2.0;
 }  // namespace ITPMethod
 }  // namespace rootMethods
 
+// Linear response configuration
+namespace linearResponse
+{
+inline double shift = 1e-10;  // diagonal regularisation / mean diagonal
+inline double singularTol = 1e-8;
+inline std::size_t polishIter = 0;  // nonlinear iterations after the solve
+}  // namespace linearResponse
+
 // Protocols configuration
 namespace protocols
 {
@@ -102,9 +150,16 @@ inline double maxStep = 1e-2;
 namespace quasiStaticStrain
 {
 inline bool errorOnNotSingleBreak = false;
-inline double strainGuessScale = 1.2;
+inline double strainGuessScale = 1.2;  // margin on the predicted break step
+inline std::size_t predictorHistory = 5;  // breaks in the non-affine correction
 }  // namespace quasiStaticStrain
 
+namespace relaxCache
+{
+inline std::size_t budget = std::size_t(256) << 20;  // bytes of positions
+inline double strainResolution = 1e-12;
+}  // namespace relaxCache
+
 namespace stepStrain
 {
 inline double stressScale = 0.9;
@@ -134,6 +189,12 @@ inline std::string fileName = "output.h5";
 }  // namespace hdf5
 }  // namespace IO
 
+namespace breakScreen
+{
+inline double skin = 0.05;  // node displacement between full break checks
+inline bool validate = false;  // full scan after every screened check
+}  // namespace breakScreen
+
 namespace partition
 {
 inline std::size_t mortonRes = 1024;
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Utils
+{
+namespace Hash
+{
+
+// splitmix64 finaliser, spreads small integers (e.g. bond indices) over 64 bits
+constexpr auto mix(std::uint64_t _x) -> std::uint64_t
+{
+  _x += 0x9e3779b97f4a7c15ULL;
+  _x = (_x ^ (_x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  _x = (_x ^ (_x >> 27)) * 0x94d049bb133111ebULL;
+  return _x ^ (_x >> 31);
+}
+
+// Order dependent combination of hashes
+constexpr auto combine(std::uint64_t _seed, std::uint64_t _value)
+    -> std::uint64_t
+{
+  return mix(_seed ^ mix(_value));
+}
+
+}  // namespace Hash
+}  // namespace Utils
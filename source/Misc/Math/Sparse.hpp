@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace Utils
+{
+namespace Math
+{
+
+// Square matrix in compressed sparse row format, columns sorted per row
+struct csrMatrix
+{
+  csrMatrix() = default;
+  csrMatrix(std::size_t _rows,
+            std::vector<std::size_t> _rowPtr,
+            std::vector<std::size_t> _cols)
+      : rows(_rows)
+      , rowPtr(std::move(_rowPtr))
+      , cols(std::move(_cols))
+      , values(cols.size(), 0.0)
+  {
+    if (rowPtr.size() != rows + 1) {
+      throw std::runtime_error("csrMatrix: rowPtr size does not match rows");
+    }
+  }
+
+  auto nnz() const -> std::size_t { return cols.size(); }
+
+  // Position of (_row, _col) in values
+  auto find(std::size_t _row, std::size_t _col) const -> std::size_t
+  {
+    const auto first = cols.begin() + rowPtr[_row];
+    const auto last = cols.begin() + rowPtr[_row + 1];
+    const auto it = std::lower_bound(first, last, _col);
+    if (it == last || *it != _col) {
+      throw std::runtime_error("csrMatrix::find: entry not in pattern");
+    }
+    return std::distance(cols.begin(), it);
+  }
+
+  void add(std::size_t _row, std::size_t _col, double _value)
+  {
+    values[find(_row, _col)] += _value;
+  }
+
+  // _y = A _x
+  void multiply(const std::vector<double>& _x, std::vector<double>& _y) const
+  {
+    _y.resize(rows);
+#pragma omp parallel for schedule(static)
+    for (std::size_t i = 0; i < rows; i++) {
+      double sum = 0.0;
+      for (std::size_t p = rowPtr[i]; p < rowPtr[i + 1]; p++) {
+        sum += values[p] * _x[cols[p]];
+      }
+      _y[i] = sum;
+    }
+  }
+
+  std::size_t rows = 0;
+  std::vector<std::size_t> rowPtr = {0};
+  std::vector<std::size_t> cols;
+  std::vector<double> values;
+};
+
+}  // namespace Math
+}  // namespace Utils
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "Misc/Math/Sparse.hpp"
+
+namespace Utils
+{
+namespace Math
+{
+
+// Up-looking sparse LDL^T factorisation of a symmetric matrix, after a
+// reverse Cuthill-McKee ordering to limit fill in. No pivoting is done, so
+// the matrix should be (close to) positive definite; a diagonal shift can be
+// added to regularise zero modes.
+class sparseLDLT
+{
+public:
+  sparseLDLT() = default;
+
+public:
+  // Factorises A + _shift I, returns false on a zero pivot
+  auto factorise(const csrMatrix& _A, double _shift = 0.0) -> bool
+  {
+    m_n = _A.rows;
+    order(_A);
+    symbolic(_A);
+    return numeric(_A, _shift);
+  }
+
+  // Solves (A + shift I) x = _b in place
+  void solve(std::vector<double>& _b) const
+  {
+    std::vector<double> x(m_n);
+    for (std::size_t i = 0; i < m_n; i++) {
+      x[i] = _b[m_perm[i]];
+    }
+    for (std::size_t j = 0; j < m_n; j++) {
+      for (std::size_t p = m_Lp[j]; p < m_Lp[j + 1]; p++) {
+        x[m_Li[p]] -= m_Lx[p] * x[j];
+      }
+    }
+    for (std::size_t j = 0; j < m_n; j++) {
+      x[j] /= m_D[j];
+    }
+    for (std::size_t j = m_n; j-- > 0;) {
+      for (std::size_t p = m_Lp[j]; p < m_Lp[j + 1]; p++) {
+        x[j] -= m_Lx[p] * x[m_Li[p]];
+      }
+    }
+    for (std::size_t i = 0; i < m_n; i++) {
+      _b[m_perm[i]] = x[i];
+    }
+  }
+
+  auto size() const -> std::size_t { return m_n; }
+  auto nnz() const -> std::size_t { return m_Lx.size(); }
+
+private:
+  static constexpr std::size_t NONE = std::numeric_limits<std::size_t>::max();
+
+  // Reverse Cuthill-McKee, m_perm[new] = old
+  void order(const csrMatrix& _A)
+  {
+    std::vector<std::size_t> degree(m_n);
+    for (std::size_t i = 0; i < m_n; i++) {
+      degree[i] = _A.rowPtr[i + 1] - _A.rowPtr[i];
+    }
+
+    std::vector<std::size_t> byDegree(m_n);
+    std::iota(byDegree.begin(), byDegree.end(), 0);
+    std::stable_sort(byDegree.begin(),
+                     byDegree.end(),
+                     [&degree](std::size_t _a, std::size_t _b)
+                     { return degree[_a] < degree[_b]; });
+
+    m_perm.clear();
+    m_perm.reserve(m_n);
+    std::vector<bool> visited(m_n, false);
+    std::vector<std::size_t> neighbours;
+    for (const auto start : byDegree) {
+      if (visited[start]) {
+        continue;
+      }
+      visited[start] = true;
+      std::size_t head = m_perm.size();
+      m_perm.push_back(start);
+      while (head < m_perm.size()) {
+        const std::size_t i = m_perm[head++];
+        neighbours.clear();
+        for (std::size_t p = _A.rowPtr[i]; p < _A.rowPtr[i + 1]; p++) {
+          if (!visited[_A.cols[p]]) {
+            visited[_A.cols[p]] = true;
+            neighbours.push_back(_A.cols[p]);
+          }
+        }
+        std::sort(neighbours.begin(),
+                  neighbours.end(),
+                  [&degree](std::size_t _a, std::size_t _b)
+                  { return degree[_a] < degree[_b]; });
+        m_perm.insert(m_perm.end(), neighbours.begin(), neighbours.end());
+      }
+    }
+    std::reverse(m_perm.begin(), m_perm.end());
+
+    m_iperm.resize(m_n);
+    for (std::size_t i = 0; i < m_n; i++) {
+      m_iperm[m_perm[i]] = i;
+    }
+  }
+
+  // Elimination tree and column counts of L
+  void symbolic(const csrMatrix& _A)
+  {
+    m_parent.assign(m_n, NONE);
+    std::vector<std::size_t> flag(m_n);
+    std::vector<std::size_t> Lnz(m_n, 0);
+
+    for (std::size_t k = 0; k < m_n; k++) {
+      flag[k] = k;
+      const std::size_t row = m_perm[k];
+      for (std::size_t p = _A.rowPtr[row]; p < _A.rowPtr[row + 1]; p++) {
+        std::size_t i = m_iperm[_A.cols[p]];
+        if (i >= k) {
+          continue;
+        }
+        for (; flag[i] != k; i = m_parent[i]) {
+          if (m_parent[i] == NONE) {
+            m_parent[i] = k;
+          }
+          Lnz[i]++;
+          flag[i] = k;
+        }
+      }
+    }
+
+    m_Lp.assign(m_n + 1, 0);
+    for (std::size_t k = 0; k < m_n; k++) {
+      m_Lp[k + 1] = m_Lp[k] + Lnz[k];
+    }
+    m_Li.resize(m_Lp[m_n]);
+    m_Lx.resize(m_Lp[m_n]);
+  }
+
+  auto numeric(const csrMatrix& _A, double _shift) -> bool
+  {
+    m_D.assign(m_n, 0.0);
+    std::vector<double> Y(m_n, 0.0);
+    std::vector<std::size_t> pattern(m_n);
+    std::vector<std::size_t> flag(m_n);
+    std::vector<std::size_t> Lnz(m_n, 0);
+
+    for (std::size_t k = 0; k < m_n; k++) {
+      // scatter column k of the permuted upper triangle and find the
+      // nonzero pattern of row k of L
+      std::size_t top = m_n;
+      flag[k] = k;
+      const std::size_t row = m_perm[k];
+      for (std::size_t p = _A.rowPtr[row]; p < _A.rowPtr[row + 1]; p++) {
+        std::size_t i = m_iperm[_A.cols[p]];
+        if (i > k) {
+          continue;
+        }
+        Y[i] += _A.values[p];
+        std::size_t len = 0;
+        for (; flag[i] != k; i = m_parent[i]) {
+          pattern[len++] = i;
+          flag[i] = k;
+        }
+        while (len > 0) {
+          pattern[--top] = pattern[--len];
+        }
+      }
+
+      m_D[k] = Y[k] + _shift;
+      Y[k] = 0.0;
+      for (; top < m_n; top++) {
+        const std::size_t i = pattern[top];
+        const double yi = Y[i];
+        Y[i] = 0.0;
+        const std::size_t pEnd = m_Lp[i] + Lnz[i];
+        for (std::size_t p = m_Lp[i]; p < pEnd; p++) {
+          Y[m_Li[p]] -= m_Lx[p] * yi;
+        }
+        const double lki = yi / m_D[i];
+        m_D[k] -= lki * yi;
+        m_Li[pEnd] = k;
+        m_Lx[pEnd] = lki;
+        Lnz[i]++;
+      }
+      if (m_D[k] == 0.0 || !std::isfinite(m_D[k])) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::size_t m_n = 0;
+  std::vector<std::size_t> m_perm;
+  std::vector<std::size_t> m_iperm;
+  std::vector<std::size_t> m_parent;
+
+  std::vector<std::size_t> m_Lp;
+  std::vector<std::size_t> m_Li;
+  std::vector<double> m_Lx;
+  std::vector<double> m_D;
+};
+
+}  // namespace Math
+}  // namespace Utils
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace Utils
+{
+
+// Max tournament tree over a fixed number of values. Each internal node holds
+// the index of the largest value below it, so the maximum is O(1), a change
+// of one value is O(log n) and the k largest values are O(k log n).
+class tournamentTree
+{
+public:
+  tournamentTree() = default;
+  tournamentTree(std::vector<double> _values) { build(std::move(_values)); }
+
+public:
+  void build(std::vector<double> _values)
+  {
+    m_n = _values.size();
+    m_cap = 1;
+    while (m_cap < m_n) {
+      m_cap *= 2;
+    }
+    m_values = std::move(_values);
+    m_values.resize(m_cap, LOWEST);
+
+    m_tree.resize(2 * m_cap);
+    for (std::size_t i = 0; i < m_cap; i++) {
+      m_tree[m_cap + i] = i;
+    }
+    for (std::size_t node = m_cap; node-- > 1;) {
+      m_tree[node] = winner(m_tree[2 * node], m_tree[2 * node + 1]);
+    }
+  }
+
+  void update(std::size_t _index, double _value)
+  {
+    m_values[_index] = _value;
+    for (std::size_t node = (m_cap + _index) / 2; node >= 1; node /= 2) {
+      m_tree[node] = winner(m_tree[2 * node], m_tree[2 * node + 1]);
+    }
+  }
+
+  auto size() const -> std::size_t { return m_n; }
+  auto value(std::size_t _index) const -> double { return m_values[_index]; }
+
+  // Index of the largest value, size() if empty
+  auto top() const -> std::size_t
+  {
+    if (m_n == 0 || m_values[m_tree[1]] == LOWEST) {
+      return m_n;
+    }
+    return m_tree[1];
+  }
+
+  // Indices of up to _k largest values above _above, largest first
+  auto topK(std::size_t _k, double _above = LOWEST) const
+      -> std::vector<std::size_t>
+  {
+    std::vector<std::size_t> result;
+    if (m_n == 0) {
+      return result;
+    }
+
+    auto cmp = [this](std::size_t _a, std::size_t _b)
+    { return m_values[m_tree[_a]] < m_values[m_tree[_b]]; };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(cmp)>
+        frontier(cmp);
+    frontier.push(1);
+    while (!frontier.empty() && result.size() < _k) {
+      const std::size_t node = frontier.top();
+      frontier.pop();
+      if (m_values[m_tree[node]] <= _above) {
+        break;
+      }
+      if (node >= m_cap) {
+        result.push_back(m_tree[node]);
+      } else {
+        frontier.push(2 * node);
+        frontier.push(2 * node + 1);
+      }
+    }
+    return result;
+  }
+
+public:
+  static constexpr double LOWEST = std::numeric_limits<double>::lowest();
+
+private:
+  auto winner(std::size_t _a, std::size_t _b) const -> std::size_t
+  {
+    return m_values[_b] > m_values[_a] ? _b : _a;
+  }
+
+private:
+  std::size_t m_n = 0;
+  std::size_t m_cap = 0;
+  std::vector<double> m_values;
+  std::vector<std::size_t> m_tree;  // leaves at [m_cap, 2 m_cap)
+};
+
+}  // namespace Utils
@@ -52,12 +52,7 @@ inline auto maxComp(const std::vector<Math::Vector<T, N>>& _vec) -> T
 
 inline auto brokenBonds(const networkV4::network& _net) -> std::size_t
 {
-  auto brokenFlag = _net.getTags().get("broken");
-  const auto& tags = _net.getBonds().getTags();
-  return std::count_if(tags.begin(),
-                       tags.end(),
-                       [&brokenFlag](const auto& tag)
-                       { return Utils::Tags::hasTag(tag, brokenFlag); });
+  return _net.getStats().broken();
 }
 
 namespace Output
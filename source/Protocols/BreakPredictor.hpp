@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <numeric>
+#include <optional>
+
+#include "Core/BondQuery.hpp"
+#include "Core/Network.hpp"
+#include "Misc/Config.hpp"
+#include "Protocols/deform.hpp"
+
+namespace networkV4
+{
+namespace protocols
+{
+
+// Estimates the strain step to the next StrainBreak. Every bond is deformed
+// affinely to find where it reaches r0 (1 + lambda). Relaxation changes
+// this, so the affine estimate is scaled by the mean ratio of the actual to
+// the predicted step over the last few breaks.
+class breakPredictor
+{
+public:
+  breakPredictor() = default;
+  breakPredictor(size_t _history)
+      : m_history(_history)
+  {
+  }
+
+public:
+  // Smallest affine strain step to a break, nullopt if no bond will break
+  auto affineStep(const network& _network, const deform::deformBase& _deform)
+      const -> std::optional<double>
+  {
+    const auto& breaks = _network.getBonds().getBreaks();
+    // the smallest step is the largest negated step
+    const auto nearest = query::scan(
+        _network,
+        {},
+        [&](size_t _index, const Utils::Math::vec2d& _dist)
+            -> std::optional<double>
+        {
+          const auto* brk =
+              std::get_if<BreakTypes::StrainBreak>(&breaks[_index]);
+          if (!brk) {
+            return std::nullopt;
+          }
+          const auto step = _deform.breakStep(
+              _network, _dist, brk->r0() * (1.0 + brk->lambda()));
+          if (!step) {
+            return std::nullopt;
+          }
+          return -step.value();
+        },
+        query::maxArg {});
+    if (!nearest.found()) {
+      return std::nullopt;
+    }
+    return -nearest.value;
+  }
+
+  // Affine step scaled by the learned correction
+  auto predict(const network& _network, const deform::deformBase& _deform)
+      -> std::optional<double>
+  {
+    m_lastAffine = affineStep(_network, _deform);
+    if (!m_lastAffine) {
+      return std::nullopt;
+    }
+    return correction() * m_lastAffine.value();
+  }
+
+  // Records the step at which the break predicted last was found
+  void record(double _actualStep)
+  {
+    if (!m_lastAffine || m_lastAffine.value() <= 0.0) {
+      return;
+    }
+    m_ratios.push_back(_actualStep / m_lastAffine.value());
+    if (m_ratios.size() > m_history) {
+      m_ratios.pop_front();
+    }
+    m_lastAffine.reset();
+  }
+
+  auto correction() const -> double
+  {
+    if (m_ratios.empty()) {
+      return 1.0;
+    }
+    return std::accumulate(m_ratios.begin(), m_ratios.end(), 0.0)
+        / static_cast<double>(m_ratios.size());
+  }
+
+private:
+  size_t m_history = config::protocols::quasiStaticStrain::predictorHistory;
+  std::deque<double> m_ratios;
+  std::optional<double> m_lastAffine;
+};
+
+}  // namespace protocols
+}  // namespace networkV4
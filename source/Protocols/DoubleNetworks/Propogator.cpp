@@ -1,4 +1,12 @@
+#include <chrono>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <span>
+
+#if defined(_OPENMP)
+#  include <omp.h>
+#endif
 
 #include "Propogator.hpp"
 
@@ -12,13 +20,26 @@ networkV4::protocols::propogatorDouble::propogatorDouble(
     double _rootTol,
     integration::AdaptiveParams _params,
     const minimisation::minimiserParams& _minParams,
-    double _maxStep)
+    double _maxStep,
+    bool _linearResponse,
+    size_t _polishIter,
+    bool _writeModuli,
+    size_t _replicas,
+    size_t _branchWorkers,
+    size_t _relaxCacheBudget)
     : protocolBase(_deform, _dataOut, _bondsOut, _networkOut, _network)
     , m_strains(_strains)
     , m_rootTol(_rootTol)
     , m_params(_params)
     , m_minParams(_minParams)
     , m_maxStep(_maxStep)
+    , m_linearResponse(_linearResponse)
+    , m_polishIter(_polishIter)
+    , m_writeModuli(_writeModuli)
+    , m_replicas(_replicas)
+    , m_branchWorkers(_branchWorkers)
+    , m_relaxCache(_relaxCacheBudget,
+                   config::protocols::relaxCache::strainResolution)
 {
   std::vector<IO::timeSeries::writeableTypes> dataHeader = {
       "Reason",
@@ -41,6 +62,9 @@ networkV4::protocols::propogatorDouble::propogatorDouble(
       "SacrificialStressXY",
       "SacrificialStressYX",
       "SacrificialStressYY"};
+  if (m_writeModuli) {
+    addModuliHeader(dataHeader);
+  }
 
   std::vector<IO::timeSeries::writeableTypes> bondHeader = {
       "StrainCount",
@@ -66,7 +90,13 @@ networkV4::protocols::propogatorDouble::propogatorDouble(
 
 void networkV4::protocols::propogatorDouble::run(network& _network)
 {
-  relax(_network);
+  const auto key = initialKey(_network, m_minParams, m_params);
+  if (!key || !loadInitial(key.value(), _network)) {
+    relax(_network);
+    if (key) {
+      saveInitial(key.value(), _network);
+    }
+  }
   m_dataOut->write(genTimeData(_network, "Initial", 0));
   m_networkOut->save(_network, 0, 0.0, "Initial");
 
@@ -75,6 +105,8 @@ void networkV4::protocols::propogatorDouble::run(network& _network)
   } else {
     runStrain(_network);
   }
+  m_replicaThroughput.report(std::cout);
+  reportRun(_network, m_relaxCache);
 }
 
 void networkV4::protocols::propogatorDouble::runLambda(network& _network)
@@ -86,12 +118,15 @@ void networkV4::protocols::propogatorDouble::runLambda(network& _network)
   }
   m_strainCount = 1;
 
+  _network.setClock(m_deform->getStrain(_network), 0.0);
   _network.computeBreaks();
-  while (!_network.getBreakQueue().empty()) {
-    const auto& broken = _network.getBreakQueue().front();
-    m_bondsOut->write(genBondData(_network, broken));
-    _network.getBreakQueue().pop_front();
-  }
+  _network.getBreakQueue().drain(
+      [&](std::span<const breakEvent> _batch)
+      {
+        for (const auto& broken : _batch) {
+          m_bondsOut->write(genBondData(_network, broken));
+        }
+      });
 
   m_dataOut->write(genTimeData(_network, "Start", 1));
   m_networkOut->save(_network, 1, 0.0, "Start");
@@ -104,6 +139,19 @@ void networkV4::protocols::propogatorDouble::runStrain(network& _network)
 {
   std::sort(m_strains.begin(), m_strains.end());
   network SavedNetwork = _network;
+  std::vector<network> branches;
+
+  // Branches in flight, oldest first. Only the loading runs here, the tasks
+  // relax, and the output is written here in target order.
+  std::deque<std::future<branch>> pending;
+#if defined(_OPENMP)
+  // The loading and every branch task get an equal share of the team
+  const int teamThreads = omp_get_max_threads();
+  const int branchThreads = std::max(
+      1, teamThreads / static_cast<int>(m_branchWorkers + 1));
+  const OMP::teamScope loadingTeam(
+      m_branchWorkers > 1 ? branchThreads : teamThreads);
+#endif
 
   for (const auto& targetStrain : m_strains) {
     while (m_deform->getStrain(_network) <= targetStrain - 1e-14) {
@@ -116,18 +164,196 @@ void networkV4::protocols::propogatorDouble::runStrain(network& _network)
     m_strainCount++;
     SavedNetwork = _network;
 
-    breakMostStrained(_network, _network.getTags().get("sacrificial"));
+    const size_t index =
+        getMaxDataIndex(_network, _network.getTags().get("sacrificial"));
+
+    // Targets only share the loading, so their break and relaxation are
+    // batched and written once the batch is full
+    if (m_replicas > 1 && !m_linearResponse) {
+      breakBond(_network, index);
+      branches.push_back(_network);
+      if (branches.size() == m_replicas) {
+        relaxBranches(SavedNetwork, branches);
+      }
+      _network = SavedNetwork;
+      continue;
+    }
+
+    // The response has to be found from the pre-break equilibrium
+    std::optional<std::vector<Utils::Math::vec2d>> response;
+    if (m_linearResponse && m_breakSolver.factorise(_network)) {
+      response = m_breakSolver.solve(_network, index);
+    }
+
+    breakBond(_network, index);
+
+    if (m_branchWorkers > 1) {
+      while (!pending.empty()
+             && (pending.size() >= m_branchWorkers
+                 || pending.front().wait_for(std::chrono::seconds(0))
+                     == std::future_status::ready))
+      {
+        writeBranch(pending.front().get());
+        pending.pop_front();
+      }
+
+      branch next {m_strainCount,
+                   genTimeData(_network, "Start", 1),
+                   _network,
+                   _network,
+                   {}};
+      pending.push_back(std::async(
+          std::launch::async,
+          [this,
+#if defined(_OPENMP)
+           branchThreads,
+#endif
+           next = std::move(next),
+           response = std::move(response)]() mutable
+          {
+#if defined(_OPENMP)
+            omp_set_num_threads(branchThreads);
+#endif
+            relaxBranch(next, response);
+            return std::move(next);
+          }));
+      _network = SavedNetwork;
+      continue;
+    }
 
     m_dataOut->write(genTimeData(_network, "Start", 1));
     m_networkOut->save(_network, m_strainCount, 0.0, "Start");
 
-    relax(_network);
+    if (response) {
+      auto& positions = _network.getNodes().positions();
+      for (size_t i = 0; i < positions.size(); i++) {
+        positions[i] += response.value()[i];
+      }
+      polish(_network);
+    } else {
+      relax(_network);
+    }
 
     m_dataOut->write(genTimeData(_network, "End", 1));
     m_networkOut->save(_network, m_strainCount, 1.0, "End");
 
     _network = SavedNetwork;
   }
+  relaxBranches(SavedNetwork, branches);
+  for (auto& task : pending) {
+    writeBranch(task.get());
+  }
+}
+
+void networkV4::protocols::propogatorDouble::relaxBranch(
+    branch& _branch,
+    const std::optional<std::vector<Utils::Math::vec2d>>& _response) const
+{
+  // A fresh preconditioner, the shared one belongs to the loading
+  auto& state = _branch.end;
+  if (_response) {
+    auto& positions = state.getNodes().positions();
+    for (size_t i = 0; i < positions.size(); i++) {
+      positions[i] += _response.value()[i];
+    }
+    if (m_polishIter > 0) {
+      auto params = m_minParams;
+      params.maxIter = m_polishIter;
+      minimisation::createMinimiser(params)->minimise(state);
+    }
+  } else {
+    minimisation::createMinimiser(m_minParams)->minimise(state);
+  }
+  state.computeForces<false, true>();
+  _branch.endData = genTimeData(state, "End", 1, _branch.strainCount);
+}
+
+void networkV4::protocols::propogatorDouble::writeBranch(const branch& _branch)
+{
+  m_dataOut->write(_branch.startData);
+  m_networkOut->save(_branch.start, _branch.strainCount, 0.0, "Start");
+  m_dataOut->write(_branch.endData);
+  m_networkOut->save(_branch.end, _branch.strainCount, 1.0, "End");
+}
+
+void networkV4::protocols::propogatorDouble::relaxBranches(
+    const network& _base, std::vector<network>& _branches)
+{
+  if (_branches.empty()) {
+    return;
+  }
+
+  replicaBatch batch(_base, _branches.size());
+  for (size_t r = 0; r < _branches.size(); r++) {
+    batch.load(r, _branches[r]);
+  }
+  minimisation::fire2Batch(m_minParams).minimise(batch);
+  m_replicaThroughput += batch.throughput();
+
+  // The branches are the targets up to and including the current one
+  const size_t strainCount = m_strainCount;
+  for (size_t r = 0; r < _branches.size(); r++) {
+    auto& branch = _branches[r];
+    m_strainCount = strainCount + 1 + r - _branches.size();
+
+    m_dataOut->write(genTimeData(branch, "Start", 1));
+    m_networkOut->save(branch, m_strainCount, 0.0, "Start");
+
+    batch.store(r, branch);
+    branch.computeForces<false, true>();
+    m_dataOut->write(genTimeData(branch, "End", 1));
+    m_networkOut->save(branch, m_strainCount, 1.0, "End");
+  }
+  m_strainCount = strainCount;
+  _branches.clear();
+}
+
+void networkV4::protocols::propogatorDouble::bracketBreak(
+    const network& _network, double _a, double _b, network& _bnet)
+{
+  const size_t R = m_replicas;
+  std::vector<network> trials(R, _network);
+  std::vector<double> strains(R);
+
+  while (std::abs(_b - _a) >= 2 * m_rootTol) {
+    replicaBatch batch(_network, R);
+    for (size_t r = 0; r < R; r++) {
+      strains[r] = _a + (_b - _a) * double(r + 1) / double(R + 1);
+      trials[r] = _network;
+      m_deform->strain(trials[r], strains[r] - m_deform->getStrain(_network));
+
+      const auto* cached = m_relaxCache.find(
+          strains[r], m_deform->name(), trials[r].getBrokenHash());
+      if (cached && cached->size() == trials[r].getNodes().size()) {
+        trials[r].getNodes().positions() = *cached;
+      }
+      batch.load(r, trials[r]);
+    }
+    minimisation::fire2Batch(m_minParams).minimise(batch);
+    m_replicaThroughput += batch.throughput();
+
+    // The first strain past the threshold brackets the break with the one
+    // before it
+    size_t first = R;
+    for (size_t r = 0; r < R; r++) {
+      batch.store(r, trials[r]);
+      trials[r].computeForces<false, true>();
+      m_relaxCache.insert(strains[r],
+                          m_deform->name(),
+                          trials[r].getBrokenHash(),
+                          trials[r].getNodes().positions());
+      if (first == R && std::get<0>(breakData(trials[r])) >= 0.0) {
+        first = r;
+      }
+    }
+    if (first < R) {
+      _b = strains[first];
+      _bnet = trials[first];
+    }
+    if (first > 0) {
+      _a = strains[first - 1];
+    }
+  }
 }
 
 void networkV4::protocols::propogatorDouble::evalStrain(network& _network,
@@ -135,92 +361,64 @@ void networkV4::protocols::propogatorDouble::evalStrain(network& _network,
 {
   const double step = _targetStrain - m_deform->getStrain(_network);
   m_deform->strain(_network, step);
+
+  const auto* cached = m_relaxCache.find(
+      _targetStrain, m_deform->name(), _network.getBrokenHash());
+  if (cached && cached->size() == _network.getNodes().size()) {
+    _network.getNodes().positions() = *cached;
+    _network.computeForces<false, true>();
+    return;
+  }
   relax(_network);
+  m_relaxCache.insert(_targetStrain,
+                      m_deform->name(),
+                      _network.getBrokenHash(),
+                      _network.getNodes().positions());
 }
 
 void networkV4::protocols::propogatorDouble::relax(network& _network)
 {
   // minimisation::AdaptiveHeunDecent minimizer(m_minParams, m_params);
-  minimisation::fire2 minimizer(m_minParams);
-  minimizer.minimise(_network);
+  auto minimizer = minimisation::createMinimiser(m_minParams, m_precond, m_copies);
+  minimizer->minimise(_network);
+  _network.computeForces<false, true>();
+}
+
+void networkV4::protocols::propogatorDouble::polish(network& _network)
+{
+  if (m_polishIter > 0) {
+    auto params = m_minParams;
+    params.maxIter = m_polishIter;
+    auto minimizer = minimisation::createMinimiser(params, m_precond, m_copies);
+    minimizer->minimise(_network);
+  }
   _network.computeForces<false, true>();
 }
 
 auto networkV4::protocols::propogatorDouble::getMaxDataIndex(
     network& _network, const Utils::Tags::tagFlags& _filter) -> size_t
 {
-  auto filter = [&_filter](const Utils::Tags::tagFlags& _tags) -> bool
-  { return Utils::Tags::hasTagAny(_tags, _filter); };
-
-  const auto& bonds = _network.getBonds();
-  const auto& positions = _network.getNodes().positions();
-  const auto& box = _network.getBox();
-
-  double max = -1e10;
-  size_t maxIndex = 0;
-  for (const auto [i, bond, type, brk, tags] :
-       ranges::views::zip(ranges::views::iota(0ul, bonds.size()),
-                          bonds.getBonds(),
-                          bonds.getTypes(),
-                          bonds.getBreaks(),
-                          bonds.getTags()))
-  {
-    if (filter(tags)) {
-      const auto& pos1 = positions[bond.src];
-      const auto& pos2 = positions[bond.dst];
-      const auto dist = box.minDist(pos1, pos2);
-
-      auto val = bonded::visitData(brk, dist);
-      if (val && val.value() > max) {
-        max = val.value();
-        maxIndex = i;
-      }
-    }
-  }
-  return maxIndex;
+  m_priority.refresh(_network);
+  const auto top = m_priority.top(priorityKey::data, _filter);
+  return top ? top.value().first : 0;
 }
 
-void networkV4::protocols::propogatorDouble::breakMostStrained(
-    network& _network, const Utils::Tags::tagFlags& _filter)
+void networkV4::protocols::propogatorDouble::breakBond(network& _network,
+                                                       size_t _index)
 {
-  size_t maxIndex = getMaxDataIndex(_network, _filter);
-  auto& bonds = _network.getBonds();
-  auto& binfo = bonds.getBonds()[maxIndex];
-  auto& type = bonds.getTypes()[maxIndex];
-  auto& brk = bonds.getBreaks()[maxIndex];
-  auto& tags = bonds.getTags()[maxIndex];
-
-  breakInfo b(binfo, type, brk, tags);
-  m_bondsOut->write(genBondData(_network, b));
-
-  type = Forces::VirtualBond {};
-  brk = BreakTypes::None {};
-  tags.set(BROKEN_TAG_INDEX);
+  _network.setClock(m_deform->getStrain(_network), 0.0);
+  m_bondsOut->write(genBondData(_network, _network.makeBreakEvent(_index)));
+
+  _network.breakBond(_index);
 }
 
 auto networkV4::protocols::propogatorDouble::breakData(const network& _network)
     -> std::tuple<double, size_t>
 {
-  double maxThres = -1e10;
-  size_t broken = 0;
-
-  const auto& nodes = _network.getNodes();
-  const auto& bonds = _network.getBonds();
-  const auto& box = _network.getBox();
-
-  for (const auto& [bond, type, brk] : ranges::views::zip(
-           bonds.getBonds(), bonds.getTypes(), bonds.getBreaks()))
-  {
-    const auto& pos1 = nodes.positions()[bond.src];
-    const auto& pos2 = nodes.positions()[bond.dst];
-    const auto dist = box.minDist(pos1, pos2);
-
-    if (bonded::visitBreak(brk, dist)) {
-      broken++;
-    }
-    maxThres =
-        std::max(maxThres, bonded::visitThreshold(brk, dist).value_or(-1e10));
-  }
+  m_priority.refresh(_network);
+  const auto top = m_priority.top(priorityKey::threshold);
+  const double maxThres = top ? top.value().second : -1e10;
+  const size_t broken = m_priority.countAbove(priorityKey::threshold, 0.0);
   return {maxThres, broken};
 }
 
@@ -260,6 +458,12 @@ auto networkV4::protocols::propogatorDouble::findSingleBreak(network& _network)
     return false;
   }
 
+  if (m_replicas > 1) {
+    bracketBreak(_network, a, b, bnet);
+    _network = bnet;
+    return true;
+  }
+
   roots::ITP solver(a, b, m_rootTol);
   for (size_t iters = 0; iters < solver.nMax(); ++iters) {
     double xITP = solver.guessRoot(a, b, maxDistAboveA, maxDistAboveB);
@@ -289,6 +493,15 @@ auto networkV4::protocols::propogatorDouble::genTimeData(
     const network& _network,
     const std::string& _reason,
     size_t _breakCount) -> std::vector<IO::timeSeries::writeableTypes>
+{
+  return genTimeData(_network, _reason, _breakCount, m_strainCount);
+}
+
+auto networkV4::protocols::propogatorDouble::genTimeData(
+    const network& _network,
+    const std::string& _reason,
+    size_t _breakCount,
+    size_t _strainCount) const -> std::vector<IO::timeSeries::writeableTypes>
 {
   const auto& stresses = _network.getStresses();
   const auto& globalStress = stresses.total();
@@ -298,31 +511,36 @@ auto networkV4::protocols::propogatorDouble::genTimeData(
 
   const auto& box = _network.getBox();
 
-  return {_reason,
-          m_strainCount,
-          _breakCount,
-          box.getLx(),
-          box.getLy(),
-          box.shearStrain(),
-          _network.getElongationStrain()[0],
-          _network.getElongationStrain()[1],
-          globalStress(0, 0),
-          globalStress(0, 1),
-          globalStress(1, 0),
-          globalStress(1, 1),
-          matStress(0, 0),
-          matStress(0, 1),
-          matStress(1, 0),
-          matStress(1, 1),
-          sacStress(0, 0),
-          sacStress(0, 1),
-          sacStress(1, 0),
-          sacStress(1, 1)};
+  std::vector<IO::timeSeries::writeableTypes> data = {
+      _reason,
+      _strainCount,
+      _breakCount,
+      box.getLx(),
+      box.getLy(),
+      box.shearStrain(),
+      _network.getElongationStrain()[0],
+      _network.getElongationStrain()[1],
+      globalStress(0, 0),
+      globalStress(0, 1),
+      globalStress(1, 0),
+      globalStress(1, 1),
+      matStress(0, 0),
+      matStress(0, 1),
+      matStress(1, 0),
+      matStress(1, 1),
+      sacStress(0, 0),
+      sacStress(0, 1),
+      sacStress(1, 0),
+      sacStress(1, 1)};
+  if (m_writeModuli) {
+    addModuliData(data, _network);
+  }
+  return data;
 }
 
 auto networkV4::protocols::propogatorDouble::genBondData(
     const network& _network,
-    const breakInfo& _bond) -> std::vector<IO::timeSeries::writeableTypes>
+    const breakEvent& _bond) -> std::vector<IO::timeSeries::writeableTypes>
 {
   auto sacTag = _network.getTags().get("sacrificial");
   auto matTag = _network.getTags().get("matrix");
@@ -334,31 +552,25 @@ auto networkV4::protocols::propogatorDouble::genBondData(
 
   const auto& box = _network.getBox();
   const auto& nodes = _network.getNodes();
-  const auto bonds = _network.getBonds();
 
-  const auto& binfo = std::get<0>(_bond);
-  const auto& type = std::get<1>(_bond);
-  const auto& brk = std::get<2>(_bond);
-  const auto tags = std::get<3>(_bond);
+  bool harmonic = _bond.harmonic;
+  bool strainBreak = _bond.strainBreak;
+  bool sacrificial = Utils::Tags::hasTag(_bond.tags, sacTag);
 
-  bool harmonic = std::holds_alternative<Forces::HarmonicBond>(type);
-  bool strainBreak = std::holds_alternative<BreakTypes::StrainBreak>(brk);
-  bool sacrificial = Utils::Tags::hasTag(tags, sacTag);
-
-  const auto& pos1 = nodes.positions()[binfo.src];
-  const auto& pos2 = nodes.positions()[binfo.dst];
-  size_t bondSrc = nodes.indices()[binfo.src];
-  size_t bondDst = nodes.indices()[binfo.dst];
+  const auto& pos1 = nodes.positions()[_bond.src];
+  const auto& pos2 = nodes.positions()[_bond.dst];
+  size_t bondSrc = nodes.indices()[_bond.src];
+  size_t bondDst = nodes.indices()[_bond.dst];
 
   double r = box.minDist(pos1, pos2).norm();
-  double r0 = harmonic ? std::get<Forces::HarmonicBond>(type).r0() : 0.0;
+  double r0 = _bond.r0;
 
   return {
       m_strainCount,
       sacrificial ? "Sacrificial" : "Matrix",
-      harmonic ? std::get<Forces::HarmonicBond>(std::get<1>(_bond)).k() : 0.0,
-      strainBreak ? std::get<BreakTypes::StrainBreak>(brk).lambda() : 0.0,
-      harmonic ? std::get<Forces::HarmonicBond>(std::get<1>(_bond)).r0() : 0.0,
+      _bond.k,
+      _bond.lambda,
+      _bond.r0,
       harmonic ? (r - r0) / r0 : 0.0,
       bondSrc,
       bondDst,
@@ -399,6 +611,31 @@ auto networkV4::protocols::propogatorDoubleReader::read(
   const double maxStep =
       toml::find_or<double>(propConfig, "MaxStep", config::protocols::maxStep);
 
+  const std::string breakSolver =
+      toml::find_or<std::string>(propConfig, "BreakSolver", "Relax");
+  if (breakSolver != "Relax" && breakSolver != "LinearResponse")
+    throw std::runtime_error("Break solver not implemented");
+
+  const size_t polishIter = toml::find_or<size_t>(
+      propConfig, "PolishIterations", config::linearResponse::polishIter);
+
+  const bool writeModuli = toml::find_or<bool>(propConfig, "Moduli", false);
+
+  const size_t replicas = toml::find_or<size_t>(propConfig, "Replicas", 1);
+  const size_t branchWorkers =
+      toml::find_or<size_t>(propConfig, "BranchWorkers", 1);
+  if (replicas > 1 && branchWorkers > 1) {
+    throw std::runtime_error("Replicas and BranchWorkers cannot be combined");
+  }
+  const size_t relaxCacheBudget = readRelaxCacheBudget(propConfig);
+  if (replicas > 1
+      && (minimiserParams.type != minimisation::minimiserType::FIRE2
+          || minimiserParams.precondition))
+  {
+    throw std::runtime_error(
+        "Replicas need the FIRE2 minimiser without preconditioning");
+  }
+
   return std::make_shared<propogatorDouble>(deform,
                                             _dataOut,
                                             _bondsOut,
@@ -408,5 +645,11 @@ auto networkV4::protocols::propogatorDoubleReader::read(
                                             tol,
                                             adaptiveParams,
                                             minimiserParams,
-                                            maxStep);
+                                            maxStep,
+                                            breakSolver == "LinearResponse",
+                                            polishIter,
+                                            writeModuli,
+                                            replicas,
+                                            branchWorkers,
+                                            relaxCacheBudget);
 }
\ No newline at end of file
@@ -1,13 +1,20 @@
 #pragma once
 
 #include <cstdint>
+#include <optional>
+#include <vector>
 
+#include "Core/BondPriority.hpp"
+#include "Core/Replicas.hpp"
 #include "Integration/Integrators/Adaptive.hpp"
-#include "Integration/Minimizers/Fire2.hpp"
+#include "Integration/LinearResponse/BreakResponse.hpp"
 #include "Integration/Minimizers/AdaptiveHeunDecent.hpp"
+#include "Integration/Minimizers/Fire2Batch.hpp"
+#include "Integration/Minimizers/Minimisers.hpp"
 #include "Misc/Config.hpp"
 #include "Misc/Roots.hpp"
 #include "Protocols/Protocol.hpp"
+#include "Protocols/RelaxCache.hpp"
 #include "Protocols/deform.hpp"
 #include "Protocols/protocolReader.hpp"
 
@@ -31,7 +38,13 @@ public:
       integration::AdaptiveParams _params = integration::AdaptiveParams(),
       const minimisation::minimiserParams& _minParams =
           minimisation::minimiserParams(),
-      double _maxStep = config::protocols::maxStep);
+      double _maxStep = config::protocols::maxStep,
+      bool _linearResponse = false,
+      size_t _polishIter = config::linearResponse::polishIter,
+      bool _writeModuli = false,
+      size_t _replicas = 1,
+      size_t _branchWorkers = 1,
+      size_t _relaxCacheBudget = config::protocols::relaxCache::budget);
   ~propogatorDouble() = default;
 
 public:
@@ -43,11 +56,39 @@ private:
 
   void evalStrain(network& _network, double _targetStrain);
   void relax(network& _network);
+  void polish(network& _network);
+
+  // A target's break and relaxation, run as a task on its own network copy
+  struct branch
+  {
+    size_t strainCount;
+    std::vector<IO::timeSeries::writeableTypes> startData;
+    network start;
+    network end;
+    std::vector<IO::timeSeries::writeableTypes> endData;
+  };
+
+  // Relaxes a branch from the broken state, through the linear response if
+  // given. Touches nothing shared, so branches can run concurrently.
+  void relaxBranch(
+      branch& _branch,
+      const std::optional<std::vector<Utils::Math::vec2d>>& _response) const;
+  void writeBranch(const branch& _branch);
+
+  // Relaxes the broken states of consecutive targets as one replica batch and
+  // writes their output. _base is the unbroken topology they share.
+  void relaxBranches(const network& _base, std::vector<network>& _branches);
+
+  // Narrows [_a, _b] to the first break by relaxing m_replicas evenly spaced
+  // strains at once. _bnet is set to the network relaxed at _b.
+  void bracketBreak(const network& _network,
+                    double _a,
+                    double _b,
+                    network& _bnet);
 
   auto getMaxDataIndex(network& _network,
                        const Utils::Tags::tagFlags& _filter) -> size_t;
-  void breakMostStrained(network& _network,
-                         const Utils::Tags::tagFlags& _filter);
+  void breakBond(network& _network, size_t _index);
   auto breakData(const network& _network) -> std::tuple<double, size_t>;
 
   auto findSingleBreak(network& _network) -> bool;
@@ -57,7 +98,12 @@ private:
                    const std::string& _reason,
                    std::size_t _breakCount)
       -> std::vector<IO::timeSeries::writeableTypes>;
-  auto genBondData(const network& _network, const breakInfo& _bond)
+  auto genTimeData(const network& _network,
+                   const std::string& _reason,
+                   std::size_t _breakCount,
+                   std::size_t _strainCount) const
+      -> std::vector<IO::timeSeries::writeableTypes>;
+  auto genBondData(const network& _network, const breakEvent& _bond)
       -> std::vector<IO::timeSeries::writeableTypes>;
 
 private:
@@ -65,10 +111,24 @@ private:
 
   integration::AdaptiveParams m_params;
   minimisation::minimiserParams m_minParams;
+  std::shared_ptr<preconditioner::blockJacobi> m_precond =
+      std::make_shared<preconditioner::blockJacobi>();
+  std::shared_ptr<minimisation::componentCopies> m_copies =
+      std::make_shared<minimisation::componentCopies>();
   double m_rootTol;
 
   size_t m_strainCount = 0;
   double m_maxStep;
+
+  bool m_linearResponse;
+  size_t m_polishIter;
+  bool m_writeModuli;
+  size_t m_replicas;
+  size_t m_branchWorkers;
+  replicaThroughput m_replicaThroughput;
+  linearResponse::breakSolver m_breakSolver;
+  bondPriority m_priority;
+  relaxCache m_relaxCache;
 };
 
 class propogatorDoubleReader : public protocolReader
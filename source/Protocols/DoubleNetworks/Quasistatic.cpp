@@ -1,4 +1,5 @@
 #include <iostream>
+#include <span>
 
 #include "Quasistatic.hpp"
 
@@ -14,7 +15,11 @@ networkV4::protocols::quasiStaticStrainDouble::quasiStaticStrainDouble(
     const minimisation::minimiserParams& _minParams,
     bool _errorOnNotSingleBreak,
     double _maxStep,
-    networkSavePoints _savePoints)
+    networkSavePoints _savePoints,
+    bool _writeModuli,
+    bool _activeSet,
+    bool _predictBreak,
+    size_t _relaxCacheBudget)
     : protocolBase(_deform, _dataOut, _bondsOut, _networkOut, _network)
     , m_maxStrain(_maxStrain)
     , m_rootTol(_rootTol)
@@ -23,7 +28,12 @@ networkV4::protocols::quasiStaticStrainDouble::quasiStaticStrainDouble(
     , m_errorOnNotSingleBreak(_errorOnNotSingleBreak)
     , m_maxStep(_maxStep)
     , m_savePoints(_savePoints)
+    , m_writeModuli(_writeModuli)
+    , m_activeSet(_activeSet)
+    , m_predictBreak(_predictBreak)
     , m_breakMinimiser(*this)
+    , m_relaxCache(_relaxCacheBudget,
+                   config::protocols::relaxCache::strainResolution)
 {
   std::vector<IO::timeSeries::writeableTypes> dataHeader = {
       "Reason",
@@ -50,6 +60,9 @@ networkV4::protocols::quasiStaticStrainDouble::quasiStaticStrainDouble(
       "SacrificialStressXY",
       "SacrificialStressYX",
       "SacrificialStressYY"};
+  if (m_writeModuli) {
+    addModuliHeader(dataHeader);
+  }
 
   std::vector<IO::timeSeries::writeableTypes> bondHeader = {
       "StrainCount",
@@ -96,7 +109,14 @@ networkV4::protocols::quasiStaticStrainDouble::~quasiStaticStrainDouble() {}
 
 void networkV4::protocols::quasiStaticStrainDouble::run(network& _network)
 {
-  _network = evalStrain(_network, 0.0);
+  const auto key = initialKey(_network, m_minParams, m_params);
+  m_deform->strain(_network, -m_deform->getStrain(_network));
+  if (!key || !loadInitial(key.value(), _network)) {
+    _network = evalStrain(_network, 0.0);
+    if (key) {
+      saveInitial(key.value(), _network);
+    }
+  }
   logData(_network, "Initial", 0, 0.0, true);
 
   while (true) {
@@ -115,6 +135,7 @@ void networkV4::protocols::quasiStaticStrainDouble::run(network& _network)
       }
       case nextBreakState::MaxStrainReached: {
         std::cout << "Max Strain Reached" << std::endl;
+        reportRun(_network, m_relaxCache);
         return;
       }
     }
@@ -127,6 +148,7 @@ void networkV4::protocols::quasiStaticStrainDouble::run(network& _network)
     if (m_oneBreak)
       break;
   }
+  reportRun(_network, m_relaxCache);
 }
 
 auto networkV4::protocols::quasiStaticStrainDouble::evalStrain(
@@ -137,9 +159,18 @@ auto networkV4::protocols::quasiStaticStrainDouble::evalStrain(
   const double step = _targetStrain - m_deform->getStrain(result);
   m_deform->strain(result, step);
 
-  minimisation::fire2 minimizer(m_minParams);
-  // minimisation::SD minimizer(m_minParams);
-  minimizer.minimise(result);
+  const auto* cached = m_relaxCache.find(
+      _targetStrain, m_deform->name(), result.getBrokenHash());
+  if (cached && cached->size() == result.getNodes().size()) {
+    result.getNodes().positions() = *cached;
+  } else {
+    auto minimizer = minimisation::createMinimiser(m_minParams, m_precond, m_copies);
+    minimizer->minimise(result);
+    m_relaxCache.insert(_targetStrain,
+                        m_deform->name(),
+                        result.getBrokenHash(),
+                        result.getNodes().positions());
+  }
   result.computeForces<false, true>();
   return result;
 }
@@ -216,6 +247,17 @@ auto networkV4::protocols::quasiStaticStrainDouble::findNextBreak(
     if (breakCountA > 1)
       return nextBreakState::FoundMultipleBreaks;
 
+    if (m_predictBreak) {
+      auto guess = m_predictor.predict(_network, *m_deform);
+      if (guess) {
+        const double step = std::max(
+            config::protocols::quasiStaticStrain::strainGuessScale
+                * guess.value(),
+            4.0 * m_rootTol);
+        b = std::min(b, a + step);
+      }
+    }
+
     m_strainCount++;
     auto bNetwork = evalStrain(_network, b);
     auto [fb, breakCountB] = breakData(bNetwork);
@@ -234,6 +276,9 @@ auto networkV4::protocols::quasiStaticStrainDouble::findNextBreak(
         throw std::runtime_error("Root not bracketed");
     }
     auto [maxDistAbove, breakCount] = breakData(_network);
+    if (breakCount > 0 && m_predictBreak) {
+      m_predictor.record(m_deform->getStrain(_network) - a);
+    }
     if (breakCount == 1)
       return nextBreakState::FoundSingleBreak;
     if (breakCount > 1)
@@ -260,34 +305,39 @@ auto networkV4::protocols::quasiStaticStrainDouble::genTimeData(
   const auto& box = _network.getBox();
   auto counts = getCounts(_network);
 
-  return {_reason,
-          m_strainCount,
-          _breakCount,
-          _t,
-          box.getLx(),
-          box.getLy(),
-          box.shearStrain(),
-          _network.getElongationStrain()[0],
-          _network.getElongationStrain()[1],
-          std::get<0>(counts),
-          std::get<1>(counts),
-          std::get<2>(counts),
-          globalStress(0, 0),
-          globalStress(0, 1),
-          globalStress(1, 0),
-          globalStress(1, 1),
-          matStress(0, 0),
-          matStress(0, 1),
-          matStress(1, 0),
-          matStress(1, 1),
-          sacStress(0, 0),
-          sacStress(0, 1),
-          sacStress(1, 0),
-          sacStress(1, 1)};
+  std::vector<IO::timeSeries::writeableTypes> data = {
+      _reason,
+      m_strainCount,
+      _breakCount,
+      _t,
+      box.getLx(),
+      box.getLy(),
+      box.shearStrain(),
+      _network.getElongationStrain()[0],
+      _network.getElongationStrain()[1],
+      std::get<0>(counts),
+      std::get<1>(counts),
+      std::get<2>(counts),
+      globalStress(0, 0),
+      globalStress(0, 1),
+      globalStress(1, 0),
+      globalStress(1, 1),
+      matStress(0, 0),
+      matStress(0, 1),
+      matStress(1, 0),
+      matStress(1, 1),
+      sacStress(0, 0),
+      sacStress(0, 1),
+      sacStress(1, 0),
+      sacStress(1, 1)};
+  if (m_writeModuli) {
+    addModuliData(data, _network);
+  }
+  return data;
 }
 
 auto networkV4::protocols::quasiStaticStrainDouble::genBondData(
-    const network& _network, const breakInfo& _bond, double _t)
+    const network& _network, const breakEvent& _bond, double _t)
     -> std::vector<IO::timeSeries::writeableTypes>
 {
   auto sacTag = _network.getTags().get("sacrificial");
@@ -302,32 +352,26 @@ auto networkV4::protocols::quasiStaticStrainDouble::genBondData(
   auto counts = getCounts(_network);
 
   const auto& nodes = _network.getNodes();
-  const auto bonds = _network.getBonds();
 
-  const auto& binfo = std::get<0>(_bond);
-  const auto& type = std::get<1>(_bond);
-  const auto& brk = std::get<2>(_bond);
-  const auto tags = std::get<3>(_bond);
+  bool harmonic = _bond.harmonic;
+  bool strainBreak = _bond.strainBreak;
+  bool sacrificial = Utils::Tags::hasTag(_bond.tags, sacTag);
 
-  bool harmonic = std::holds_alternative<Forces::HarmonicBond>(type);
-  bool strainBreak = std::holds_alternative<BreakTypes::StrainBreak>(brk);
-  bool sacrificial = Utils::Tags::hasTag(tags, sacTag);
-
-  const auto& pos1 = nodes.positions()[binfo.src];
-  const auto& pos2 = nodes.positions()[binfo.dst];
-  size_t bondSrc = nodes.indices()[binfo.src];
-  size_t bondDst = nodes.indices()[binfo.dst];
+  const auto& pos1 = nodes.positions()[_bond.src];
+  const auto& pos2 = nodes.positions()[_bond.dst];
+  size_t bondSrc = nodes.indices()[_bond.src];
+  size_t bondDst = nodes.indices()[_bond.dst];
 
   double r = box.minDist(pos1, pos2).norm();
-  double r0 = harmonic ? std::get<Forces::HarmonicBond>(type).r0() : 0.0;
+  double r0 = _bond.r0;
 
   return {
       m_strainCount,
       _t,
       sacrificial ? "Sacrificial" : "Matrix",
-      harmonic ? std::get<Forces::HarmonicBond>(std::get<1>(_bond)).k() : 0.0,
-      strainBreak ? std::get<BreakTypes::StrainBreak>(brk).lambda() : 0.0,
-      harmonic ? std::get<Forces::HarmonicBond>(std::get<1>(_bond)).r0() : 0.0,
+      _bond.k,
+      _bond.lambda,
+      _bond.r0,
       harmonic ? (r - r0) / r0 : 0.0,
       bondSrc,
       bondDst,
@@ -375,27 +419,10 @@ auto networkV4::protocols::quasiStaticStrainDouble::getCounts(
     const network& _network)
     -> std::tuple<std::size_t, std::size_t, std::size_t>
 {
-  std::size_t bondCount = 0;
-  std::size_t sacrificialCount = 0;
-  std::size_t matrixCount = 0;
-
-  auto sacTag = _network.getTags().get("sacrificial");
-  const auto& bonds = _network.getBonds();
-
-  for (const auto& [bond, type, tags] :
-       ranges::views::zip(bonds.getBonds(), bonds.getTypes(), bonds.getTags()))
-  {
-    if (std::holds_alternative<Forces::VirtualBond>(type)) {
-      continue;
-    }
-    bondCount++;
-    if (Utils::Tags::hasTag(tags, sacTag)) {
-      sacrificialCount++;
-    } else {
-      matrixCount++;
-    }
-  }
-  return {bondCount, sacrificialCount, matrixCount};
+  const auto& stats = _network.getStats();
+  const size_t sacrificialCount =
+      stats.live(_network.getTags().get("sacrificial"));
+  return {stats.live(), sacrificialCount, stats.live() - sacrificialCount};
 }
 
 auto networkV4::protocols::quasiStaticStrainDouble::checkIfNeedToSave(
@@ -420,38 +447,22 @@ auto networkV4::protocols::quasiStaticStrainDouble::processBreakQueue(
   if (_network.getBreakQueue().empty())
     return 0;
   _network.computeForces<false, true>();
-  size_t breakCount = _network.getBreakQueue().size();
-  while (!_network.getBreakQueue().empty()) {
-    const auto& broken = _network.getBreakQueue().front();
-    m_bondsOut->write(genBondData(_network, broken, _t));
-    _network.getBreakQueue().pop_front();
-  }
-  return breakCount;
+  return _network.getBreakQueue().drain(
+      [&](std::span<const breakEvent> _batch)
+      {
+        for (const auto& broken : _batch) {
+          m_bondsOut->write(genBondData(_network, broken, _t));
+        }
+      });
 }
 
 auto networkV4::protocols::quasiStaticStrainDouble::breakData(
     const network& _network) -> std::tuple<double, size_t>
 {
-  double maxThres = -1e10;
-  size_t broken = 0;
-
-  const auto& nodes = _network.getNodes();
-  const auto& bonds = _network.getBonds();
-  const auto& box = _network.getBox();
-
-  for (const auto& [bond, type, brk] : ranges::views::zip(
-           bonds.getBonds(), bonds.getTypes(), bonds.getBreaks()))
-  {
-    const auto& pos1 = nodes.positions()[bond.src];
-    const auto& pos2 = nodes.positions()[bond.dst];
-    const auto dist = box.minDist(pos1, pos2);
-
-    if (bonded::visitBreak(brk, dist)) {
-      broken++;
-    }
-    maxThres =
-        std::max(maxThres, bonded::visitThreshold(brk, dist).value_or(-1e10));
-  }
+  m_priority.refresh(_network);
+  const auto top = m_priority.top(priorityKey::threshold);
+  const double maxThres = top ? top.value().second : -1e10;
+  const size_t broken = m_priority.countAbove(priorityKey::threshold, 0.0);
   return {maxThres, broken};
 }
 
@@ -460,20 +471,43 @@ auto networkV4::protocols::quasiStaticStrainDouble::breakData(
 void networkV4::protocols::quasiStaticStrainDouble::relaxBreak::minimise(
     network& _network)
 {
+  const double strain = m_protocol.m_deform->getStrain(_network);
+  _network.setClock(strain, 0.0);
   _network.computeForces<true, true>();
+  std::vector<size_t> seeds;
+  for (const auto& broken : _network.getBreakQueue()) {
+    seeds.push_back(broken.src);
+    seeds.push_back(broken.dst);
+  }
   size_t breakCount = m_protocol.processBreakQueue(_network, 0.0);
+  m_screen.reset(_network);
 
   bool dump = m_protocol.checkIfNeedToSave(_network).has_value();
   m_protocol.logData(_network, "Start", breakCount, 0.0, dump);
 
+  double t = 0.0;
+  bool localConverged = false;
+  if (m_protocol.m_activeSet) {
+    t = localRelax(_network, seeds, breakCount);
+    _network.setClock(strain, t);
+
+    // full check, the local phase only tracks the forces near the break
+    _network.computeForces<true, false>();
+    m_screen.reset(_network);
+    const bool brokenInCheck = !_network.getBreakQueue().empty();
+    breakCount += m_protocol.processBreakQueue(_network, t);
+    double fdotf = Utils::Math::xdoty(_network.getNodes().forces(),
+                                      _network.getNodes().forces());
+    localConverged = !brokenInCheck && fdotf < m_Ftol * m_Ftol;
+  }
+
   double Ecurr = _network.getEnergy();
   double Eprev = Ecurr;
 
   integration::AdaptiveOverdampedEulerHeun stepper(1.0, m_params);
 
-  double t = 0.0;
   size_t iter = 0;
-  while (iter++ < m_maxIter) {
+  while (!localConverged && iter++ < m_maxIter) {
     Eprev = Ecurr;
 
     auto status = hybridStep(_network, stepper);
@@ -494,9 +528,13 @@ void networkV4::protocols::quasiStaticStrainDouble::relaxBreak::minimise(
       break;
     }
 
-    _network.computeForces<true, false>();
+    // hybridStep leaves the forces current, only the breaks are needed
+    if (m_screen.check(_network) > 0) {
+      _network.computeForces();
+    }
     Ecurr = _network.getEnergy();
     t += status.value();
+    _network.setClock(strain, t);
 
     bool brokenInStep = !_network.getBreakQueue().empty();
     breakCount += m_protocol.processBreakQueue(_network, t);
@@ -514,6 +552,25 @@ void networkV4::protocols::quasiStaticStrainDouble::relaxBreak::minimise(
   m_protocol.logData(_network, "End", breakCount, t, dump);
 }
 
+auto networkV4::protocols::quasiStaticStrainDouble::relaxBreak::localRelax(
+    network& _network, const std::vector<size_t>& _seeds, size_t& _breakCount)
+    -> double
+{
+  m_localRelax.clear();
+  auto state = m_localRelax.relax<true>(_network, _seeds);
+  while (state == minimisation::activeSetState::broken) {
+    const double t = m_localRelax.getTime();
+    _breakCount += m_protocol.processBreakQueue(_network, t);
+    _network.setClock(m_protocol.m_deform->getStrain(_network), t);
+    auto reason = m_protocol.checkIfNeedToSave(_network);
+    if (reason) {
+      m_protocol.logData(_network, reason.value(), _breakCount, t, true);
+    }
+    state = m_localRelax.relax<true>(_network, {});
+  }
+  return m_localRelax.getTime();
+}
+
 auto networkV4::protocols::quasiStaticStrainDouble::relaxBreak::hybridStep(
     network& _network, auto& _stepper)
     -> tl::expected<double, lineSearch::lineSearchState>
@@ -575,6 +632,12 @@ auto networkV4::protocols::quasiStaticStrainDoubleReader::read(
 
   auto saveConfig = readSavePoints(quasiConfig);
 
+  const bool writeModuli = toml::find_or<bool>(quasiConfig, "Moduli", false);
+  const bool activeSet = toml::find_or<bool>(quasiConfig, "ActiveSet", false);
+  const bool predictBreak =
+      toml::find_or<bool>(quasiConfig, "PredictBreak", false);
+  const size_t relaxCacheBudget = readRelaxCacheBudget(quasiConfig);
+
   return std::make_shared<quasiStaticStrainDouble>(deform,
                                                    _dataOut,
                                                    _bondsOut,
@@ -586,7 +649,11 @@ auto networkV4::protocols::quasiStaticStrainDoubleReader::read(
                                                    minimiserParams,
                                                    errorOnNotSingleBreak,
                                                    maxStep,
-                                                   saveConfig);
+                                                   saveConfig,
+                                                   writeModuli,
+                                                   activeSet,
+                                                   predictBreak,
+                                                   relaxCacheBudget);
 }
 
 auto networkV4::protocols::quasiStaticStrainDoubleReader::readSavePoints(
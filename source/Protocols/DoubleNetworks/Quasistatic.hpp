@@ -4,13 +4,17 @@
 
 #include <tl/expected.hpp>
 
+#include "Core/BreakScreen.hpp"
+#include "Core/BondPriority.hpp"
 #include "Integration/Integrators/Adaptive.hpp"
+#include "Integration/Minimizers/ActiveSet.hpp"
 #include "Integration/Minimizers/AdaptiveHeunDecent.hpp"
-#include "Integration/Minimizers/Fire2.hpp"
-#include "Integration/Minimizers/SD.hpp"
+#include "Integration/Minimizers/Minimisers.hpp"
 #include "Misc/Config.hpp"
 #include "Misc/Roots.hpp"
+#include "Protocols/BreakPredictor.hpp"
 #include "Protocols/Protocol.hpp"
+#include "Protocols/RelaxCache.hpp"
 #include "Protocols/deform.hpp"
 #include "Protocols/protocolReader.hpp"
 
@@ -56,6 +60,7 @@ public:
         : minimiserBase(_protocol.m_minParams)
         , m_params(_protocol.m_params)
         , m_protocol(_protocol)
+        , m_localRelax(_protocol.m_minParams, _protocol.m_params)
     {
     }
 
@@ -66,9 +71,16 @@ public:
     auto hybridStep(network& _network, auto& _stepper)
         -> tl::expected<double, lineSearch::lineSearchState>;
 
+    // Relaxes the region around the bonds broken so far, returns the time
+    auto localRelax(network& _network,
+                    const std::vector<size_t>& _seeds,
+                    size_t& _breakCount) -> double;
+
   private:
     integration::AdaptiveParams m_params;
     quasiStaticStrainDouble& m_protocol;
+    minimisation::activeSetRelax m_localRelax;
+    breakScreen m_screen;
   };
 
 private:
@@ -77,6 +89,10 @@ private:
 
   integration::AdaptiveParams m_params;
   minimisation::minimiserParams m_minParams;
+  std::shared_ptr<preconditioner::blockJacobi> m_precond =
+      std::make_shared<preconditioner::blockJacobi>();
+  std::shared_ptr<minimisation::componentCopies> m_copies =
+      std::make_shared<minimisation::componentCopies>();
   double m_rootTol;
 
   bool m_errorOnNotSingleBreak;
@@ -86,7 +102,13 @@ private:
   std::size_t m_strainCount = 0;
 
   networkSavePoints m_savePoints;
+  bool m_writeModuli;
+  bool m_activeSet;
+  bool m_predictBreak;
+  breakPredictor m_predictor;
   relaxBreak m_breakMinimiser;
+  bondPriority m_priority;
+  relaxCache m_relaxCache;
 
 public:
   quasiStaticStrainDouble() = delete;
@@ -103,7 +125,11 @@ public:
           minimisation::minimiserParams(),
       bool _errorOnNotSingleBreak = false,
       double _maxStep = config::protocols::maxStep,
-      networkSavePoints _savePoints = networkSavePoints());
+      networkSavePoints _savePoints = networkSavePoints(),
+      bool _writeModuli = false,
+      bool _activeSet = false,
+      bool _predictBreak = false,
+      size_t _relaxCacheBudget = config::protocols::relaxCache::budget);
   ~quasiStaticStrainDouble();
 
 public:
@@ -128,7 +154,7 @@ private:
                    std::size_t _breakCount,
                    double _t = 0.0)
       -> std::vector<IO::timeSeries::writeableTypes>;
-  auto genBondData(const network& _network, const breakInfo& _bond, double _t)
+  auto genBondData(const network& _network, const breakEvent& _bond, double _t)
       -> std::vector<IO::timeSeries::writeableTypes>;
   void logData(network& _network,
                const std::string& _reason,
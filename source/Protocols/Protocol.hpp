@@ -1,10 +1,22 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
 
 #include "Core/Network.hpp"
+#include "IO/Input/RelaxedCache.hpp"
 #include "IO/NetworkDump/NetworkOut.hpp"
 #include "IO/TimeSeries/DataOut.hpp"
+#include "Integration/Integrators/Adaptive.hpp"
+#include "Integration/LinearResponse/Moduli.hpp"
+#include "Integration/Minimizers/MinimiserBase.hpp"
+#include "Misc/Hash.hpp"
+#include "Protocols/RelaxCache.hpp"
 #include "deform.hpp"
 
 namespace networkV4
@@ -31,15 +43,112 @@ public:
 public:
   virtual void run(network& _network) = 0;
 
+  // Relaxed initial states are read from and written to _cache, _inputHash
+  // identifies the input file
+  void setInitialCache(std::shared_ptr<IO::NetworkIn::relaxedCache> _cache,
+                       std::uint64_t _inputHash)
+  {
+    m_initialCache = std::move(_cache);
+    m_inputHash = _inputHash;
+  }
+
+protected:
+  // Key of the relaxed state of _network, which has not been relaxed yet.
+  // Covers every setting the relaxed result depends on. nullopt if there is
+  // no cache.
+  auto initialKey(const network& _network,
+                  const minimisation::minimiserParams& _params,
+                  const integration::AdaptiveParams& _adaptive) const
+      -> std::optional<std::uint64_t>
+  {
+    if (!m_initialCache) {
+      return std::nullopt;
+    }
+    using Utils::Hash::combine;
+    auto bits = [](double _value)
+    { return std::bit_cast<std::uint64_t>(_value); };
+    std::uint64_t key = m_inputHash;
+    key = combine(key, bits(_params.Ftol));
+    key = combine(key, bits(_params.Etol));
+    key = combine(key, _params.maxIter);
+    key = combine(key, static_cast<std::uint64_t>(_params.type));
+    key = combine(key, static_cast<std::uint64_t>(_params.beta));
+    key = combine(key, _params.precondition);
+    key = combine(key, _params.components);
+    key = combine(key, _adaptive.maxInnerIter);
+    key = combine(key, bits(_adaptive.dtMin));
+    key = combine(key, bits(_adaptive.dtMax));
+    key = combine(key, bits(_adaptive.qMin));
+    key = combine(key, bits(_adaptive.qMax));
+    key = combine(key, bits(_adaptive.espRel));
+    key = combine(key, bits(_adaptive.espAbs));
+    key = combine(key, std::hash<std::string> {}(m_deform->name()));
+    // catches a different node order from the partitioning
+    key = combine(key, IO::NetworkIn::relaxedCache::hashPositions(_network));
+    return key;
+  }
+
+  auto loadInitial(std::uint64_t _key, network& _network) const -> bool
+  {
+    if (!m_initialCache || !m_initialCache->load(_key, _network)) {
+      return false;
+    }
+    _network.computeForces<false, true>();
+    return true;
+  }
+
+  void saveInitial(std::uint64_t _key, const network& _network) const
+  {
+    if (m_initialCache) {
+      m_initialCache->save(_key, _network);
+    }
+  }
+
+  // End of run statistics: relax cache and force evaluations
+  void reportRun(const network& _network, const relaxCache& _cache) const
+  {
+    _cache.report(std::cout);
+    std::cout << "Force evaluations: " << _network.getForceEvaluations()
+              << " computed, " << _network.getAvoidedEvaluations()
+              << " avoided" << std::endl;
+  }
+
 protected:
   std::shared_ptr<deform::deformBase> m_deform;
 
   std::shared_ptr<IO::timeSeries::timeSeriesOut> m_dataOut;
   std::shared_ptr<IO::timeSeries::timeSeriesOut> m_bondsOut;
   std::shared_ptr<IO::networkDumps::networkDump> m_networkOut;
+
+  std::shared_ptr<IO::NetworkIn::relaxedCache> m_initialCache;
+  std::uint64_t m_inputHash = 0;
 };
 
 std::vector<double> forceMags(const network& _network);
 
+inline void addModuliHeader(
+    std::vector<IO::timeSeries::writeableTypes>& _header)
+{
+  _header.insert(_header.end(),
+                 {"ShearModulus",
+                  "BulkModulus",
+                  "AffineShearModulus",
+                  "AffineBulkModulus"});
+}
+
+// Moduli of _network, which should be at equilibrium; NaN if the Hessian
+// could not be factorised
+inline void addModuliData(std::vector<IO::timeSeries::writeableTypes>& _data,
+                          const network& _network)
+{
+  const auto moduli = linearResponse::computeModuli(_network);
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  _data.insert(_data.end(),
+               {moduli ? moduli->shear : nan,
+                moduli ? moduli->bulk : nan,
+                moduli ? moduli->affineShear : nan,
+                moduli ? moduli->affineBulk : nan});
+}
+
 }  // namespace protocols
 }  // namespace networkV4
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Misc/Config.hpp"
+#include "Misc/Hash.hpp"
+#include "Misc/Math/Vector.hpp"
+
+namespace networkV4
+{
+namespace protocols
+{
+
+// LRU cache of relaxed node positions keyed by the strain, the deformation
+// mode and the hash of the broken bond set. Entries are dropped from the
+// least recently used end once the positions stored exceed the budget.
+class relaxCache
+{
+public:
+  relaxCache() = default;
+  relaxCache(std::size_t _budget, double _resolution)
+      : m_budget(_budget)
+      , m_resolution(_resolution)
+  {
+  }
+
+public:
+  // Relaxed positions for the key, nullptr on a miss
+  auto find(double _strain, const std::string& _mode, std::uint64_t _broken)
+      -> const std::vector<Utils::Math::vec2d>*
+  {
+    m_lookups++;
+    const auto it = m_map.find(makeKey(_strain, _mode, _broken));
+    if (it == m_map.end()) {
+      return nullptr;
+    }
+    m_hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return &it->second->positions;
+  }
+
+  void insert(double _strain,
+              const std::string& _mode,
+              std::uint64_t _broken,
+              const std::vector<Utils::Math::vec2d>& _positions)
+  {
+    const std::size_t bytes = _positions.size() * sizeof(Utils::Math::vec2d);
+    if (bytes > m_budget) {
+      return;
+    }
+
+    const auto key = makeKey(_strain, _mode, _broken);
+    const auto it = m_map.find(key);
+    if (it != m_map.end()) {
+      m_used -= it->second->positions.size() * sizeof(Utils::Math::vec2d);
+      m_lru.erase(it->second);
+      m_map.erase(it);
+    }
+
+    while (m_used + bytes > m_budget) {
+      const auto& last = m_lru.back();
+      m_used -= last.positions.size() * sizeof(Utils::Math::vec2d);
+      m_map.erase(last.id);
+      m_lru.pop_back();
+    }
+
+    m_lru.push_front({key, _positions});
+    m_map[key] = m_lru.begin();
+    m_used += bytes;
+  }
+
+  auto hits() const -> std::size_t { return m_hits; }
+  auto lookups() const -> std::size_t { return m_lookups; }
+
+  void report(std::ostream& _out) const
+  {
+    const double rate = m_lookups > 0
+        ? 100.0 * static_cast<double>(m_hits) / static_cast<double>(m_lookups)
+        : 0.0;
+    _out << "Relax cache: " << m_hits << " hits from " << m_lookups
+         << " lookups (" << rate << "%)" << std::endl;
+  }
+
+private:
+  struct key
+  {
+    std::int64_t strain;
+    std::uint64_t mode;
+    std::uint64_t broken;
+
+    auto operator==(const key& _other) const -> bool = default;
+  };
+
+  struct keyHash
+  {
+    auto operator()(const key& _key) const -> std::size_t
+    {
+      return Utils::Hash::mix(static_cast<std::uint64_t>(_key.strain)
+                              ^ Utils::Hash::mix(_key.mode ^ _key.broken));
+    }
+  };
+
+  struct entry
+  {
+    key id;
+    std::vector<Utils::Math::vec2d> positions;
+  };
+
+  // Strains are quantised so round off in the target does not miss
+  auto makeKey(double _strain,
+               const std::string& _mode,
+               std::uint64_t _broken) const -> key
+  {
+    return {std::llround(_strain / m_resolution),
+            std::hash<std::string> {}(_mode),
+            _broken};
+  }
+
+private:
+  std::size_t m_budget = config::protocols::relaxCache::budget;
+  double m_resolution = config::protocols::relaxCache::strainResolution;
+  std::size_t m_used = 0;
+
+  std::list<entry> m_lru;
+  std::unordered_map<key, std::list<entry>::iterator, keyHash> m_map;
+
+  std::size_t m_hits = 0;
+  std::size_t m_lookups = 0;
+};
+
+}  // namespace protocols
+}  // namespace networkV4
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cmath>
+#include <optional>
+#include <string>
+
 #include "Core/Network.hpp"
 
 namespace networkV4
@@ -16,8 +20,18 @@ public:
   virtual ~deformBase() = default;
 
 public:
+  virtual auto name() const -> std::string = 0;
   virtual auto getStrain(const network& _network) const -> double = 0;
   virtual void strain(network& _network, double _step) = 0;
+
+  // Smallest strain step for which the affine deformation stretches _dist to
+  // _length, nullopt if it never does
+  virtual auto breakStep(const network& _network,
+                         const Utils::Math::vec2d& _dist,
+                         double _length) const -> std::optional<double>
+  {
+    return std::nullopt;
+  }
 };
 
 class shear : public deformBase
@@ -27,6 +41,8 @@ public:
   virtual ~shear() = default;
 
 public:
+  auto name() const -> std::string override { return "Shear"; }
+
   auto getStrain(const network& _network) const -> double override
   {
     return _network.getShearStrain();
@@ -36,6 +52,23 @@ public:
   {
     _network.shear(_step);
   }
+
+  // |d + step (dy, 0)| = _length
+  auto breakStep(const network& _network,
+                 const Utils::Math::vec2d& _dist,
+                 double _length) const -> std::optional<double> override
+  {
+    if (_dist.norm2() >= _length * _length) {
+      return 0.0;
+    }
+    if (_dist[1] == 0.0) {
+      return std::nullopt;
+    }
+    // the roots have opposite signs as |d| < _length
+    const double root = std::sqrt(_length * _length - _dist[1] * _dist[1]);
+    return std::max((-_dist[0] - root) / _dist[1],
+                    (-_dist[0] + root) / _dist[1]);
+  }
 };
 
 class elongationAreaY : public deformBase
@@ -45,6 +78,8 @@ public:
   virtual ~elongationAreaY() = default;
 
 public:
+  auto name() const -> std::string override { return "Elongation"; }
+
   auto getStrain(const network& _network) const -> double override
   {
     return _network.getElongationStrain()[1];
@@ -61,6 +96,29 @@ public:
     box newBox(newDomain, _network.getBox().getxy());
     _network.setBox(newBox);
   }
+
+  // With k = (1 + strain + step) / (1 + strain) an untilted box maps
+  // (dx, dy) to (dx / k, k dy), so u = k^2 solves dy^2 u^2 - l^2 u + dx^2 = 0.
+  // The tilt is ignored, this is only used as an estimate.
+  auto breakStep(const network& _network,
+                 const Utils::Math::vec2d& _dist,
+                 double _length) const -> std::optional<double> override
+  {
+    if (_dist.norm2() >= _length * _length) {
+      return 0.0;
+    }
+    const double dx2 = _dist[0] * _dist[0];
+    const double dy2 = _dist[1] * _dist[1];
+    const double l2 = _length * _length;
+    const double disc = l2 * l2 - 4.0 * dx2 * dy2;
+    if (dy2 == 0.0 || disc < 0.0) {
+      return std::nullopt;
+    }
+    // the smaller root is below 1 as |d| < _length
+    const double u = (l2 + std::sqrt(disc)) / (2.0 * dy2);
+    const double strain = _network.getElongationStrain()[1];
+    return (std::sqrt(u) - 1.0) * (1.0 + strain);
+  }
 };
 
 }  // namespace deform
@@ -63,6 +63,14 @@ protected:
     return params;
   }
 
+  // Bytes of relaxed positions the relax cache keeps, given in MB
+  auto readRelaxCacheBudget(const toml::value& _config) -> size_t
+  {
+    const size_t megabytes = toml::find_or<size_t>(
+        _config, "RelaxCacheMB", config::protocols::relaxCache::budget >> 20);
+    return megabytes << 20;
+  }
+
   auto readMinimiser(const toml::value& _config)
       -> minimisation::minimiserParams
   {
@@ -77,6 +85,31 @@ protected:
     if (config.contains("maxIter"))
       params.maxIter = toml::find<size_t>(config, "maxIter");
 
+    const std::string type =
+        toml::find_or<std::string>(config, "Type", "FIRE2");
+    if (type == "FIRE2")
+      params.type = minimisation::minimiserType::FIRE2;
+    else if (type == "SD")
+      params.type = minimisation::minimiserType::SD;
+    else if (type == "CG")
+      params.type = minimisation::minimiserType::CG;
+    else if (type == "NewtonCG")
+      params.type = minimisation::minimiserType::NewtonCG;
+    else
+      throw std::runtime_error("Minimiser type not implemented");
+
+    const std::string beta = toml::find_or<std::string>(config, "Beta", "PR+");
+    if (beta == "PR+")
+      params.beta = minimisation::cgBeta::PolakRibierePlus;
+    else if (beta == "HZ")
+      params.beta = minimisation::cgBeta::HagerZhang;
+    else
+      throw std::runtime_error("CG beta not implemented");
+
+    params.precondition = toml::find_or<bool>(config, "Precondition", false);
+
+    params.components = toml::find_or<bool>(config, "Components", false);
+
     return params;
   }
 };
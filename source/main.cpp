@@ -7,6 +7,11 @@ auto main(int argc, char* argv[]) -> int
   std::filesystem::path path =
       argc == 2 ? argv[1] : "/home/sam/Documents/Code/NetworkV4/test/test.toml";
 
+  if (networkV4::Sweep::isSweep(path)) {
+    networkV4::Sweep sweep(path);
+    return sweep.run() == 0 ? 0 : 1;
+  }
+
   networkV4::Simulation input(path);
   
   input.run();